@@ -0,0 +1,58 @@
+/***************************************************************************
+* Copyright: Testo SE & Co. KGaA, Testo-Straße 1, 79849 Lenzkirch
+***************************************************************************/
+/**@file
+@brief<b>Description: </b> coloring of computed live ir frames
+
+***************************************************************************/
+
+#ifndef IR_API_EXAMPLE_FRAME_PALETTE_H
+#define IR_API_EXAMPLE_FRAME_PALETTE_H
+
+/***************************************************************************
+* Includes
+***************************************************************************/
+
+#include <irapi/IrTypes.h>
+
+#include <algorithm>
+
+#include <opencv2/core/core.hpp>
+
+/**
+**************************************************************************
+colors matIrData of a frame with its scale gradient, for frames whose
+temperature data was not delivered by the camera (replay, upscaling)
+
+@param [in, out] frame matIrData, fScaleMin, fScaleMax and
+                 matScaleGradient are read, matIrBgr is written; the image
+                 is black without a gradient or with an empty scale range
+**************************************************************************/
+inline void palletizeFrame(irapi::IrFrame& frame)
+{
+  // the gradient is indexed as one array, a roi of a larger image is copied
+  const cv::Mat3b matGradient = frame.matScaleGradient.isContinuous() ?
+    frame.matScaleGradient : cv::Mat3b(frame.matScaleGradient.clone());
+  frame.matIrBgr.create(frame.matIrData.size());
+  if (matGradient.empty() || frame.fScaleMax <= frame.fScaleMin)
+  {
+    frame.matIrBgr.setTo(cv::Scalar::all(0));
+    return;
+  }
+
+  const int nMaxIndex = int(matGradient.total()) - 1;
+  const float fScale = nMaxIndex / (frame.fScaleMax - frame.fScaleMin);
+  const cv::Vec3b* pGradient = matGradient.ptr<cv::Vec3b>();
+  for (int y = 0; y < frame.matIrData.rows; y++)
+  {
+    const float* pData = frame.matIrData[y];
+    cv::Vec3b* pBgr = frame.matIrBgr[y];
+    for (int x = 0; x < frame.matIrData.cols; x++)
+    {
+      int nIndex = cvRound((pData[x] - frame.fScaleMin) * fScale);
+      pBgr[x] = pGradient[std::min(std::max(nIndex, 0), nMaxIndex)];
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,773 @@
+/***************************************************************************
+* Copyright: Testo SE & Co. KGaA, Testo-Straße 1, 79849 Lenzkirch
+***************************************************************************/
+/**@file
+@brief<b>Description: </b> columnar bulk export of measurement results
+
+***************************************************************************/
+
+#ifndef IR_API_EXAMPLE_MEASUREMENT_EXPORT_H
+#define IR_API_EXAMPLE_MEASUREMENT_EXPORT_H
+
+/***************************************************************************
+* Includes
+***************************************************************************/
+
+#include <irapi/Image.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <limits>
+#include <ostream>
+#include <istream>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <exception>
+#include <stdexcept>
+
+/**
+**************************************************************************
+@brief One chunk of measurement rows, stored column by column
+
+Every active measurement point and area of an image is one row. Image
+values (file, timestamp, serial number, emissivity, reflected temperature)
+are repeated in each row of the image. String columns are dictionary
+encoded: every distinct string is stored once per chunk, the rows contain
+the index.
+**************************************************************************/
+struct MeasurementChunk
+{
+  enum MeasurementType
+  {
+    MeasurementPoint = 0,
+    MeasurementArea = 1
+  };
+
+  /**
+  *************************************************************************
+  add all active measurement points and areas of an image, the chunk is
+  unchanged if an exception is thrown
+
+  @param [in] strFile file name of the image
+  @param [in] image image
+  ************************************************************************/
+  void addImage(const std::string& strFile, const irapi::Image& image)
+  {
+    const size_t nRows = getRows();
+    const size_t nFiles = vecFileDictionary.size();
+    const size_t nKeys = vecKeyDictionary.size();
+    try
+    {
+      addRows(strFile, image);
+    }
+    catch (...)
+    {
+      // a partial image would leave columns of different length
+      truncate(nRows, nFiles, nKeys);
+      throw;
+    }
+  }
+
+  size_t getRows() const { return vecFile.size(); }
+
+  void clear()
+  {
+    *this = MeasurementChunk();
+  }
+
+  // string columns (index into the dictionary of the chunk)
+  std::vector<std::string> vecFileDictionary;
+  std::vector<uint32_t> vecFile;
+  std::vector<std::string> vecKeyDictionary;
+  std::vector<uint32_t> vecKey;
+
+  std::vector<uint64_t> vecTimestamp;
+  std::vector<uint64_t> vecSerialNumber;
+  std::vector<float> vecEmissivity;
+  std::vector<float> vecReflectedTemperature;
+
+  // MeasurementType
+  std::vector<uint8_t> vecType;
+
+  // position and size (points: width = height = 1)
+  std::vector<int32_t> vecX;
+  std::vector<int32_t> vecY;
+  std::vector<int32_t> vecWidth;
+  std::vector<int32_t> vecHeight;
+
+  // point value or area mean value (degree Celsius or %rH)
+  std::vector<float> vecValue;
+
+  // hot and cold spot of areas (NaN and -1 if not active)
+  std::vector<int32_t> vecHotX;
+  std::vector<int32_t> vecHotY;
+  std::vector<float> vecHotValue;
+  std::vector<int32_t> vecColdX;
+  std::vector<int32_t> vecColdY;
+  std::vector<float> vecColdValue;
+
+private:
+  void addRows(const std::string& strFile, const irapi::Image& image)
+  {
+    // every image is a new file, no search in the file dictionary
+    vecFileDictionary.push_back(strFile);
+    const uint32_t nFile = uint32_t(vecFileDictionary.size() - 1);
+    const uint64_t nTimestamp = image.getFileDateTime();
+    const uint64_t nSerialNumber = image.getDeviceSerialNumber();
+    const float fEmissivity = image.getEmissivity();
+    const float fReflectedTemperature = image.getReflectedTemperature();
+    const float fNaN = std::numeric_limits<float>::quiet_NaN();
+
+    auto addRow = [&](const std::string& strKey, uint8_t nType)
+    {
+      vecFile.push_back(nFile);
+      vecTimestamp.push_back(nTimestamp);
+      vecSerialNumber.push_back(nSerialNumber);
+      vecEmissivity.push_back(fEmissivity);
+      vecReflectedTemperature.push_back(fReflectedTemperature);
+      vecType.push_back(nType);
+      vecKey.push_back(addString(vecKeyDictionary, strKey));
+    };
+
+    for (const auto& item : image.getActiveMeasPoints())
+    {
+      const irapi::MeasPoint& point = item.second;
+      addRow(item.first, MeasurementPoint);
+      addRect(point.nX, point.nY, 1, 1);
+      vecValue.push_back(point.fValue);
+      addSpot(vecHotX, vecHotY, vecHotValue, point, false, fNaN);
+      addSpot(vecColdX, vecColdY, vecColdValue, point, false, fNaN);
+    }
+
+    for (const auto& item : image.getActiveMeasAreas())
+    {
+      const irapi::MeasArea& area = item.second;
+      addRow(item.first, MeasurementArea);
+      addRect(area.nX, area.nY, area.nWidth, area.nHeight);
+      vecValue.push_back(area.fMeanValue);
+      addSpot(vecHotX, vecHotY, vecHotValue, area.hotspot, area.bHotSpotActive, fNaN);
+      addSpot(vecColdX, vecColdY, vecColdValue, area.coldspot, area.bColdspotActive, fNaN);
+    }
+  }
+
+  // shrinking does not throw
+  void truncate(size_t nRows, size_t nFiles, size_t nKeys)
+  {
+    vecFileDictionary.resize(nFiles);
+    vecKeyDictionary.resize(nKeys);
+    vecFile.resize(nRows);
+    vecKey.resize(nRows);
+    vecTimestamp.resize(nRows);
+    vecSerialNumber.resize(nRows);
+    vecEmissivity.resize(nRows);
+    vecReflectedTemperature.resize(nRows);
+    vecType.resize(nRows);
+    vecX.resize(nRows);
+    vecY.resize(nRows);
+    vecWidth.resize(nRows);
+    vecHeight.resize(nRows);
+    vecValue.resize(nRows);
+    vecHotX.resize(nRows);
+    vecHotY.resize(nRows);
+    vecHotValue.resize(nRows);
+    vecColdX.resize(nRows);
+    vecColdY.resize(nRows);
+    vecColdValue.resize(nRows);
+  }
+
+  // the key dictionary is small (a few keys per image), a linear search is enough
+  static uint32_t addString(std::vector<std::string>& vecDictionary, const std::string& str)
+  {
+    auto it = std::find(vecDictionary.rbegin(), vecDictionary.rend(), str);
+    if (it != vecDictionary.rend())
+    {
+      return uint32_t(vecDictionary.rend() - it - 1);
+    }
+    vecDictionary.push_back(str);
+    return uint32_t(vecDictionary.size() - 1);
+  }
+
+  void addRect(int nX, int nY, int nWidth, int nHeight)
+  {
+    vecX.push_back(nX);
+    vecY.push_back(nY);
+    vecWidth.push_back(nWidth);
+    vecHeight.push_back(nHeight);
+  }
+
+  static void addSpot(std::vector<int32_t>& vecSpotX, std::vector<int32_t>& vecSpotY, std::vector<float>& vecSpotValue,
+                      const irapi::MeasPoint& point, bool bActive, float fNaN)
+  {
+    vecSpotX.push_back(bActive ? point.nX : -1);
+    vecSpotY.push_back(bActive ? point.nY : -1);
+    vecSpotValue.push_back(bActive ? point.fValue : fNaN);
+  }
+};
+
+/**
+**************************************************************************
+@brief Columnar writer for measurement chunks
+
+File layout (little endian):
+
+  "IRCOLS01"                       magic
+  chunk data                       columns of chunk 0, chunk 1, ...
+  footer
+  uint64 footer offset
+  "IRCOLS01"                       magic
+
+Column data is the raw array of the values (no per value formatting).
+String columns are stored as uint32 dictionary size, per entry uint32
+length + UTF-8 bytes, followed by the uint32 index per row.
+
+Footer:
+
+  uint32 column count
+  per column:  uint8 type, uint16 name length, name
+  uint32 chunk count
+  per chunk:   uint64 row count, per column uint64 offset + uint64 size
+
+Type codes: 0 uint8, 1 int32, 2 uint32, 3 uint64, 4 float32, 5 string.
+A reader only needs the footer to seek to the columns it is interested in.
+**************************************************************************/
+class MeasurementColumnWriter
+{
+public:
+  enum ColumnType
+  {
+    TypeUInt8 = 0,
+    TypeInt32 = 1,
+    TypeUInt32 = 2,
+    TypeUInt64 = 3,
+    TypeFloat32 = 4,
+    TypeString = 5
+  };
+
+  /**
+  *************************************************************************
+  @param [in] os output stream (binary)
+  ************************************************************************/
+  explicit MeasurementColumnWriter(std::ostream& os)
+    : m_os(os)
+    , m_nOffset(0)
+    , m_bFinished(false)
+  {
+    writeRaw(szMagic(), 8);
+  }
+
+  ~MeasurementColumnWriter()
+  {
+    try
+    {
+      finish();
+    }
+    catch (...)
+    {
+    }
+  }
+
+  /**
+  *************************************************************************
+  append a chunk (thread safe, the chunk is serialized before the lock)
+  (throws std::runtime_error if writing failed)
+  ************************************************************************/
+  void writeChunk(const MeasurementChunk& chunk)
+  {
+    if (chunk.getRows() == 0) return;
+
+    std::vector<unsigned char> vecData;
+    std::vector<uint64_t> vecSizes;
+    vecSizes.reserve(nColumns);
+
+    forEachColumn(chunk, [&](const char*, ColumnType type, const void* pData, size_t nBytes,
+                             const std::vector<std::string>* pDictionary)
+    {
+      if (nBytes != chunk.getRows() * getValueSize(type))
+      {
+        throw std::runtime_error("MeasurementColumnWriter: columns of the chunk differ in length");
+      }
+
+      const size_t nStart = vecData.size();
+      if (pDictionary)
+      {
+        appendValue(vecData, uint32_t(pDictionary->size()));
+        for (const std::string& str : *pDictionary)
+        {
+          appendValue(vecData, uint32_t(str.size()));
+          vecData.insert(vecData.end(), str.begin(), str.end());
+        }
+      }
+      const unsigned char* pBytes = static_cast<const unsigned char*>(pData);
+      vecData.insert(vecData.end(), pBytes, pBytes + nBytes);
+      vecSizes.push_back(vecData.size() - nStart);
+    });
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ChunkInfo info;
+    info.nRows = chunk.getRows();
+    uint64_t nOffset = m_nOffset;
+    for (uint64_t nSize : vecSizes)
+    {
+      info.vecColumns.push_back(std::make_pair(nOffset, nSize));
+      nOffset += nSize;
+    }
+    writeRaw(vecData.data(), vecData.size());
+    m_vecChunks.push_back(info);
+  }
+
+  /**
+  *************************************************************************
+  write the footer (called by the destructor if not called before)
+  (throws std::runtime_error if writing failed)
+  ************************************************************************/
+  void finish()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_bFinished) return;
+    m_bFinished = true;
+
+    std::vector<unsigned char> vecFooter;
+    appendValue(vecFooter, uint32_t(nColumns));
+    forEachColumn(MeasurementChunk(), [&](const char* szName, ColumnType type, const void*, size_t,
+                                          const std::vector<std::string>*)
+    {
+      const size_t nLength = std::strlen(szName);
+      appendValue(vecFooter, uint8_t(type));
+      appendValue(vecFooter, uint16_t(nLength));
+      vecFooter.insert(vecFooter.end(), szName, szName + nLength);
+    });
+
+    appendValue(vecFooter, uint32_t(m_vecChunks.size()));
+    for (const ChunkInfo& info : m_vecChunks)
+    {
+      appendValue(vecFooter, info.nRows);
+      for (const auto& column : info.vecColumns)
+      {
+        appendValue(vecFooter, column.first);
+        appendValue(vecFooter, column.second);
+      }
+    }
+
+    const uint64_t nFooterOffset = m_nOffset;
+    appendValue(vecFooter, nFooterOffset);
+    vecFooter.insert(vecFooter.end(), szMagic(), szMagic() + 8);
+    writeRaw(vecFooter.data(), vecFooter.size());
+    m_os.flush();
+    if (!m_os)
+    {
+      throw std::runtime_error("MeasurementColumnWriter: could not write the footer");
+    }
+  }
+
+  /**
+  *************************************************************************
+  @return number of rows written so far
+  ************************************************************************/
+  uint64_t getRows() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint64_t nRows = 0;
+    for (const ChunkInfo& info : m_vecChunks) nRows += info.nRows;
+    return nRows;
+  }
+
+  /**
+  *************************************************************************
+  @return bytes per row of a column (string columns: the index)
+  ************************************************************************/
+  static size_t getValueSize(ColumnType type)
+  {
+    switch (type)
+    {
+    case TypeUInt8: return 1;
+    case TypeUInt64: return 8;
+    default: return 4;
+    }
+  }
+
+private:
+  static const size_t nColumns = 18;
+
+  struct ChunkInfo
+  {
+    uint64_t nRows;
+    std::vector<std::pair<uint64_t, uint64_t> > vecColumns;
+  };
+
+  static const char* szMagic() { return "IRCOLS01"; }
+
+  // calls fn(name, type, data, bytes, dictionary) for all columns in file order
+  template <typename Fn>
+  static void forEachColumn(const MeasurementChunk& chunk, Fn fn)
+  {
+    fn("file", TypeString, chunk.vecFile.data(), bytes(chunk.vecFile), &chunk.vecFileDictionary);
+    fn("timestamp", TypeUInt64, chunk.vecTimestamp.data(), bytes(chunk.vecTimestamp), nullptr);
+    fn("serial_number", TypeUInt64, chunk.vecSerialNumber.data(), bytes(chunk.vecSerialNumber), nullptr);
+    fn("emissivity", TypeFloat32, chunk.vecEmissivity.data(), bytes(chunk.vecEmissivity), nullptr);
+    fn("reflected_temperature", TypeFloat32, chunk.vecReflectedTemperature.data(), bytes(chunk.vecReflectedTemperature), nullptr);
+    fn("type", TypeUInt8, chunk.vecType.data(), bytes(chunk.vecType), nullptr);
+    fn("key", TypeString, chunk.vecKey.data(), bytes(chunk.vecKey), &chunk.vecKeyDictionary);
+    fn("x", TypeInt32, chunk.vecX.data(), bytes(chunk.vecX), nullptr);
+    fn("y", TypeInt32, chunk.vecY.data(), bytes(chunk.vecY), nullptr);
+    fn("width", TypeInt32, chunk.vecWidth.data(), bytes(chunk.vecWidth), nullptr);
+    fn("height", TypeInt32, chunk.vecHeight.data(), bytes(chunk.vecHeight), nullptr);
+    fn("value", TypeFloat32, chunk.vecValue.data(), bytes(chunk.vecValue), nullptr);
+    fn("hot_x", TypeInt32, chunk.vecHotX.data(), bytes(chunk.vecHotX), nullptr);
+    fn("hot_y", TypeInt32, chunk.vecHotY.data(), bytes(chunk.vecHotY), nullptr);
+    fn("hot_value", TypeFloat32, chunk.vecHotValue.data(), bytes(chunk.vecHotValue), nullptr);
+    fn("cold_x", TypeInt32, chunk.vecColdX.data(), bytes(chunk.vecColdX), nullptr);
+    fn("cold_y", TypeInt32, chunk.vecColdY.data(), bytes(chunk.vecColdY), nullptr);
+    fn("cold_value", TypeFloat32, chunk.vecColdValue.data(), bytes(chunk.vecColdValue), nullptr);
+  }
+
+  template <typename T>
+  static size_t bytes(const std::vector<T>& vec) { return vec.size() * sizeof(T); }
+
+  template <typename T>
+  static void appendValue(std::vector<unsigned char>& vec, T value)
+  {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(&value);
+    vec.insert(vec.end(), p, p + sizeof(T));
+  }
+
+  void writeRaw(const void* pData, size_t nSize)
+  {
+    m_os.write(static_cast<const char*>(pData), std::streamsize(nSize));
+    if (!m_os)
+    {
+      throw std::runtime_error("MeasurementColumnWriter: write failed");
+    }
+    m_nOffset += nSize;
+  }
+
+  std::ostream& m_os;
+  uint64_t m_nOffset;
+  bool m_bFinished;
+  std::vector<ChunkInfo> m_vecChunks;
+  mutable std::mutex m_mutex;
+};
+
+/**
+**************************************************************************
+@brief Reader of the columnar file of MeasurementColumnWriter
+
+The constructor reads the footer (throws std::runtime_error for a file
+that is not complete or not valid), the columns of a chunk are read on
+request.
+**************************************************************************/
+class MeasurementColumnReader
+{
+public:
+  typedef MeasurementColumnWriter::ColumnType ColumnType;
+
+  /**
+  *************************************************************************
+  @param [in] is input stream (binary, seekable)
+  ************************************************************************/
+  explicit MeasurementColumnReader(std::istream& is)
+    : m_is(is)
+    , m_nFooterOffset(0)
+  {
+    m_is.seekg(0, std::ios::end);
+    const uint64_t nFileSize = uint64_t(m_is.tellg());
+    if (!m_is || nFileSize < 24)
+    {
+      throw std::runtime_error("MeasurementColumnReader: file too small");
+    }
+
+    char aMagic[8];
+    readRaw(0, aMagic, 8);
+    if (std::memcmp(aMagic, "IRCOLS01", 8) != 0)
+    {
+      throw std::runtime_error("MeasurementColumnReader: invalid file");
+    }
+    readRaw(nFileSize - 16, &m_nFooterOffset, 8);
+    readRaw(nFileSize - 8, aMagic, 8);
+    if (std::memcmp(aMagic, "IRCOLS01", 8) != 0 || m_nFooterOffset < 8 || m_nFooterOffset > nFileSize - 16)
+    {
+      throw std::runtime_error("MeasurementColumnReader: missing footer");
+    }
+
+    std::vector<char> vecFooter(size_t(nFileSize - 16 - m_nFooterOffset));
+    readRaw(m_nFooterOffset, vecFooter.data(), vecFooter.size());
+    size_t nPos = 0;
+
+    const uint32_t nColumns = readValue<uint32_t>(vecFooter, nPos);
+    for (uint32_t i = 0; i < nColumns; i++)
+    {
+      const uint8_t nType = readValue<uint8_t>(vecFooter, nPos);
+      const uint16_t nLength = readValue<uint16_t>(vecFooter, nPos);
+      if (nType > MeasurementColumnWriter::TypeString || nLength > vecFooter.size() - nPos)
+      {
+        throw std::runtime_error("MeasurementColumnReader: invalid footer");
+      }
+      m_vecColumns.push_back(std::make_pair(std::string(vecFooter.data() + nPos, nLength), ColumnType(nType)));
+      nPos += nLength;
+    }
+
+    const uint32_t nChunks = readValue<uint32_t>(vecFooter, nPos);
+    for (uint32_t i = 0; i < nChunks; i++)
+    {
+      Chunk chunk;
+      chunk.nRows = readValue<uint64_t>(vecFooter, nPos);
+      for (uint32_t c = 0; c < nColumns; c++)
+      {
+        const uint64_t nOffset = readValue<uint64_t>(vecFooter, nPos);
+        const uint64_t nSize = readValue<uint64_t>(vecFooter, nPos);
+        if (nOffset < 8 || nOffset > m_nFooterOffset || nSize > m_nFooterOffset - nOffset)
+        {
+          throw std::runtime_error("MeasurementColumnReader: column outside of the file");
+        }
+        chunk.vecColumns.push_back(std::make_pair(nOffset, nSize));
+      }
+      m_vecChunks.push_back(chunk);
+    }
+  }
+
+  MeasurementColumnReader(const MeasurementColumnReader& other) = delete;
+  MeasurementColumnReader& operator= (const MeasurementColumnReader& rhs) = delete;
+
+  // name and type of the columns in file order
+  const std::vector<std::pair<std::string, ColumnType> >& getColumns() const { return m_vecColumns; }
+
+  size_t getChunks() const { return m_vecChunks.size(); }
+
+  uint64_t getRows(size_t nChunk) const { return m_vecChunks.at(nChunk).nRows; }
+
+  uint64_t getRows() const
+  {
+    uint64_t nRows = 0;
+    for (const Chunk& chunk : m_vecChunks) nRows += chunk.nRows;
+    return nRows;
+  }
+
+  /**
+  *************************************************************************
+  @return index of a column, -1 if the file has no such column
+  ************************************************************************/
+  int findColumn(const std::string& strName) const
+  {
+    for (size_t i = 0; i < m_vecColumns.size(); i++)
+    {
+      if (m_vecColumns[i].first == strName) return int(i);
+    }
+    return -1;
+  }
+
+  /**
+  *************************************************************************
+  read a value column of a chunk, T has to match the column type
+  ************************************************************************/
+  template <typename T>
+  void readColumn(size_t nChunk, size_t nColumn, std::vector<T>& vecValues)
+  {
+    const Chunk& chunk = m_vecChunks.at(nChunk);
+    const auto& column = chunk.vecColumns.at(nColumn);
+    if (m_vecColumns[nColumn].second == MeasurementColumnWriter::TypeString ||
+        MeasurementColumnWriter::getValueSize(m_vecColumns[nColumn].second) != sizeof(T) ||
+        column.second != chunk.nRows * sizeof(T))
+    {
+      throw std::runtime_error("MeasurementColumnReader: invalid column " + m_vecColumns[nColumn].first);
+    }
+
+    vecValues.resize(size_t(chunk.nRows));
+    readRaw(column.first, vecValues.data(), size_t(column.second));
+  }
+
+  /**
+  *************************************************************************
+  read a string column of a chunk
+
+  @param [out] vecDictionary distinct strings of the chunk
+  @param [out] vecIndex index into the dictionary per row
+  ************************************************************************/
+  void readStringColumn(size_t nChunk, size_t nColumn, std::vector<std::string>& vecDictionary,
+                        std::vector<uint32_t>& vecIndex)
+  {
+    const Chunk& chunk = m_vecChunks.at(nChunk);
+    const auto& column = chunk.vecColumns.at(nColumn);
+    if (m_vecColumns[nColumn].second != MeasurementColumnWriter::TypeString)
+    {
+      throw std::runtime_error("MeasurementColumnReader: invalid column " + m_vecColumns[nColumn].first);
+    }
+
+    std::vector<char> vecData(size_t(column.second));
+    readRaw(column.first, vecData.data(), vecData.size());
+    size_t nPos = 0;
+
+    vecDictionary.resize(readValue<uint32_t>(vecData, nPos));
+    for (std::string& str : vecDictionary)
+    {
+      const uint32_t nLength = readValue<uint32_t>(vecData, nPos);
+      if (nLength > vecData.size() - nPos)
+      {
+        throw std::runtime_error("MeasurementColumnReader: invalid column " + m_vecColumns[nColumn].first);
+      }
+      str.assign(vecData.data() + nPos, nLength);
+      nPos += nLength;
+    }
+
+    if (vecData.size() - nPos != chunk.nRows * sizeof(uint32_t))
+    {
+      throw std::runtime_error("MeasurementColumnReader: invalid column " + m_vecColumns[nColumn].first);
+    }
+    vecIndex.resize(size_t(chunk.nRows));
+    std::memcpy(vecIndex.data(), vecData.data() + nPos, vecData.size() - nPos);
+    for (uint32_t nIndex : vecIndex)
+    {
+      if (nIndex >= vecDictionary.size())
+      {
+        throw std::runtime_error("MeasurementColumnReader: invalid column " + m_vecColumns[nColumn].first);
+      }
+    }
+  }
+
+private:
+  struct Chunk
+  {
+    uint64_t nRows;
+    std::vector<std::pair<uint64_t, uint64_t> > vecColumns;
+  };
+
+  template <typename T>
+  static T readValue(const std::vector<char>& vec, size_t& nPos)
+  {
+    if (vec.size() - nPos < sizeof(T))
+    {
+      throw std::runtime_error("MeasurementColumnReader: unexpected end of data");
+    }
+    T value;
+    std::memcpy(&value, vec.data() + nPos, sizeof(T));
+    nPos += sizeof(T);
+    return value;
+  }
+
+  void readRaw(uint64_t nOffset, void* pData, size_t nSize)
+  {
+    m_is.clear();
+    m_is.seekg(std::streamoff(nOffset));
+    m_is.read(static_cast<char*>(pData), std::streamsize(nSize));
+    if (m_is.gcount() != std::streamsize(nSize))
+    {
+      throw std::runtime_error("MeasurementColumnReader: read failed");
+    }
+  }
+
+  std::istream& m_is;
+  uint64_t m_nFooterOffset;
+  std::vector<std::pair<std::string, ColumnType> > m_vecColumns;
+  std::vector<Chunk> m_vecChunks;
+};
+
+/**
+**************************************************************************
+@brief Result of exportMeasurements
+**************************************************************************/
+struct MeasurementExportResult
+{
+  uint64_t nImages;
+  uint64_t nRows;
+
+  // files that could not be loaded and the error message
+  std::vector<std::pair<std::string, std::string> > vecFailed;
+};
+
+/**
+**************************************************************************
+export the measurement results of a batch of images
+
+The files are loaded by nThreads worker threads, every worker fills its
+own chunk and hands it to the writer if nRowsPerChunk is reached. The
+row order in the file depends on the thread timing, the file column
+identifies the image of every row.
+
+@param [in] vecFiles bmt files
+@param [in] writer column writer
+@param [in] nThreads number of worker threads
+@param [in] nRowsPerChunk rows per chunk
+@return number of images and rows, failed files
+(throws the error of the writer, the other workers stop then)
+**************************************************************************/
+inline MeasurementExportResult exportMeasurements(const std::vector<std::string>& vecFiles,
+                                                  MeasurementColumnWriter& writer,
+                                                  int nThreads, size_t nRowsPerChunk = 65536)
+{
+  MeasurementExportResult result;
+  result.nImages = 0;
+  result.nRows = 0;
+
+  std::atomic<size_t> nNextFile(0);
+  std::mutex mutexResult;
+  std::exception_ptr pWriteError;
+
+  auto worker = [&]()
+  {
+    MeasurementChunk chunk;
+    uint64_t nImages = 0;
+    uint64_t nRows = 0;
+
+    try
+    {
+      for (size_t i = nNextFile++; i < vecFiles.size(); i = nNextFile++)
+      {
+        try
+        {
+          irapi::Image image(vecFiles[i]);
+          chunk.addImage(vecFiles[i], image);
+          nImages++;
+        }
+        catch (std::exception& e)
+        {
+          std::lock_guard<std::mutex> lock(mutexResult);
+          result.vecFailed.push_back(std::make_pair(vecFiles[i], std::string(e.what())));
+          continue;
+        }
+
+        if (chunk.getRows() >= nRowsPerChunk)
+        {
+          writer.writeChunk(chunk);
+          nRows += chunk.getRows();
+          chunk.clear();
+        }
+      }
+
+      writer.writeChunk(chunk);
+      nRows += chunk.getRows();
+    }
+    catch (...)
+    {
+      // writer error, stop the other workers
+      nNextFile = vecFiles.size();
+      std::lock_guard<std::mutex> lock(mutexResult);
+      if (!pWriteError) pWriteError = std::current_exception();
+    }
+
+    std::lock_guard<std::mutex> lock(mutexResult);
+    result.nImages += nImages;
+    result.nRows += nRows;
+  };
+
+  std::vector<std::thread> vecThreads;
+  for (int i = 1; i < nThreads; i++)
+  {
+    vecThreads.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : vecThreads)
+  {
+    thread.join();
+  }
+
+  if (pWriteError)
+  {
+    std::rethrow_exception(pWriteError);
+  }
+  return result;
+}
+
+#endif
@@ -0,0 +1,592 @@
+/***************************************************************************
+* Copyright: Testo SE & Co. KGaA, Testo-Straße 1, 79849 Lenzkirch
+***************************************************************************/
+/**@file
+@brief<b>Description: </b> export of radiometric data to tiled TIFF and 16 bit PNG
+
+***************************************************************************/
+
+#ifndef IR_API_EXAMPLE_RADIOMETRIC_EXPORT_H
+#define IR_API_EXAMPLE_RADIOMETRIC_EXPORT_H
+
+/***************************************************************************
+* Includes
+***************************************************************************/
+
+#include <irapi/Image.h>
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <sstream>
+#include <ostream>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgcodecs/imgcodecs.hpp>
+
+typedef std::vector<std::pair<std::string, std::string> > RadiometricMetaData;
+
+/**
+*************************************************************************
+collect the calibration and measurement parameters of an image
+
+@param [in] image ir image
+@return list of {key, value}
+************************************************************************/
+inline RadiometricMetaData getRadiometricMetaData(const irapi::Image& image)
+{
+  RadiometricMetaData metaData;
+  metaData.push_back(std::make_pair("Device", image.getDeviceName()));
+  metaData.push_back(std::make_pair("SerialNumber", std::to_string(image.getDeviceSerialNumber())));
+  metaData.push_back(std::make_pair("Timestamp", std::to_string(image.getFileDateTime())));
+  metaData.push_back(std::make_pair("Emissivity", std::to_string(image.getEmissivity())));
+  metaData.push_back(std::make_pair("EmissivityMaterial", image.getEmissivityMaterial()));
+  metaData.push_back(std::make_pair("ReflectedTemperature", std::to_string(image.getReflectedTemperature())));
+  metaData.push_back(std::make_pair("HumidityMode", image.getHumidityModeActive() ? "1" : "0"));
+  if (image.getHumidityModeActive())
+  {
+    metaData.push_back(std::make_pair("Humidity", std::to_string(image.getHumidity())));
+    metaData.push_back(std::make_pair("AmbientTemperature", std::to_string(image.getAmbientTemperature())));
+  }
+  return metaData;
+}
+
+/**
+**************************************************************************
+@brief Encoding of temperatures in 16 bit integers
+
+  value = (temperature + fOffset) * fScale
+
+Centi Kelvin (fOffset 273.15, fScale 100) covers temperatures up to
+382 degree Celsius, above deci Kelvin is used (fScale 10).
+**************************************************************************/
+struct RadiometricEncoding
+{
+  float fOffset;
+  float fScale;
+
+  static RadiometricEncoding forData(const cv::Mat_<float>& matData)
+  {
+    double dMax = 0.0;
+    cv::minMaxLoc(matData, nullptr, &dMax);
+
+    RadiometricEncoding encoding;
+    encoding.fOffset = 273.15f;
+    encoding.fScale = ((dMax + 273.15) * 100.0 < 65535.0) ? 100.0f : 10.0f;
+    return encoding;
+  }
+
+  void addTo(RadiometricMetaData& metaData) const
+  {
+    metaData.push_back(std::make_pair("Encoding", "value = (temperature [degree Celsius] + offset) * scale"));
+    metaData.push_back(std::make_pair("EncodingOffset", std::to_string(fOffset)));
+    metaData.push_back(std::make_pair("EncodingScale", std::to_string(fScale)));
+  }
+
+  unsigned short encode(float fValue) const
+  {
+    return cv::saturate_cast<unsigned short>((fValue + fOffset) * fScale);
+  }
+};
+
+/**
+**************************************************************************
+@brief Tiled TIFF writer for radiometric data
+
+Writes float32 (degree Celsius) or uint16 (RadiometricEncoding) tiles,
+compressed with LZW and the TIFF predictor (horizontal differencing for
+uint16, floating point predictor for float32). The metadata is stored as
+"key=value" lines in the ImageDescription tag.
+
+Tiles are converted from the source image and compressed by worker
+threads. The compressed tiles are written to the stream in order as soon
+as they are ready; only a small window of tiles is kept in memory.
+The stream must be seekable (the offset of the directory is written last).
+**************************************************************************/
+class RadiometricTiffWriter
+{
+public:
+  RadiometricTiffWriter()
+    : m_nTileSize(64)
+    , m_nThreads(std::max(1, int(std::thread::hardware_concurrency())))
+    , m_bCompression(true)
+  {
+  }
+
+  // tile width and height (multiple of 16)
+  void setTileSize(int nTileSize) { m_nTileSize = std::max(16, (nTileSize + 15) / 16 * 16); }
+  void setThreads(int nThreads) { m_nThreads = std::max(1, nThreads); }
+  void setCompression(bool bCompression) { m_bCompression = bCompression; }
+
+  /**
+  *************************************************************************
+  write a radiometric image
+
+  @param [in] os output stream (binary, seekable)
+  @param [in] matData temperature data in degree Celsius
+  @param [in] metaData calibration and measurement parameters
+  @param [in] bUInt16 write uint16 with RadiometricEncoding instead of float32
+  ************************************************************************/
+  void write(std::ostream& os, const cv::Mat_<float>& matData, RadiometricMetaData metaData, bool bUInt16)
+  {
+    if (matData.empty()) throw std::invalid_argument("RadiometricTiffWriter: empty image");
+
+    const RadiometricEncoding encoding = RadiometricEncoding::forData(matData);
+    if (bUInt16) encoding.addTo(metaData);
+    else metaData.push_back(std::make_pair("Unit", "degree Celsius"));
+
+    const std::streamoff nStart = os.tellp();
+    const int nTilesX = (matData.cols + m_nTileSize - 1) / m_nTileSize;
+    const int nTilesY = (matData.rows + m_nTileSize - 1) / m_nTileSize;
+    const int nTiles = nTilesX * nTilesY;
+
+    // header, the directory offset is written at the end
+    const char szHeader[8] = { 'I', 'I', 42, 0, 0, 0, 0, 0 };
+    os.write(szHeader, sizeof(szHeader));
+
+    std::vector<uint32_t> vecOffsets(nTiles);
+    std::vector<uint32_t> vecByteCounts(nTiles);
+
+    const int nWindow = 2 * m_nThreads;
+    std::vector<std::vector<unsigned char> > vecSlots(nWindow);
+    std::vector<int> vecSlotTile(nWindow, -1);
+    std::mutex mutex;
+    std::condition_variable cond;
+    int nNextTile = 0;
+    int nNextWrite = 0;
+    bool bAbort = false;
+
+    auto worker = [&]()
+    {
+      std::vector<unsigned char> vecRaw;
+      std::vector<unsigned char> vecCompressed;
+      while (true)
+      {
+        int nTile = 0;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          cond.wait(lock, [&] { return bAbort || nNextTile >= nTiles || nNextTile < nNextWrite + nWindow; });
+          if (bAbort || nNextTile >= nTiles) return;
+          nTile = nNextTile++;
+        }
+
+        encodeTile(matData, nTile % nTilesX, nTile / nTilesX, bUInt16, encoding, vecRaw);
+        if (m_bCompression)
+        {
+          compressLzw(vecRaw, vecCompressed);
+        }
+        else
+        {
+          vecCompressed.swap(vecRaw);
+        }
+
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          vecSlots[nTile % nWindow].swap(vecCompressed);
+          vecSlotTile[nTile % nWindow] = nTile;
+        }
+        cond.notify_all();
+      }
+    };
+
+    std::vector<std::thread> vecThreads;
+    for (int i = 0; i < std::min(m_nThreads, nTiles); i++)
+    {
+      vecThreads.push_back(std::thread(worker));
+    }
+
+    // write tiles in order
+    std::vector<unsigned char> vecTile;
+    for (int nTile = 0; nTile < nTiles && os; nTile++)
+    {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&] { return vecSlotTile[nTile % nWindow] == nTile; });
+        vecTile.swap(vecSlots[nTile % nWindow]);
+        vecSlotTile[nTile % nWindow] = -1;
+      }
+
+      vecOffsets[nTile] = uint32_t(os.tellp() - nStart);
+      vecByteCounts[nTile] = uint32_t(vecTile.size());
+      os.write(reinterpret_cast<const char*>(vecTile.data()), vecTile.size());
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        nNextWrite = nTile + 1;
+      }
+      cond.notify_all();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      bAbort = true;
+    }
+    cond.notify_all();
+    for (auto& thread : vecThreads)
+    {
+      thread.join();
+    }
+
+    if (!os) throw std::runtime_error("RadiometricTiffWriter: write error");
+
+    writeDirectory(os, nStart, matData.size(), bUInt16, metaData, vecOffsets, vecByteCounts);
+  }
+
+private:
+  // convert one tile and apply the predictor if compressed (tiles at the border are padded)
+  void encodeTile(const cv::Mat_<float>& matData, int nTileX, int nTileY, bool bUInt16,
+                  const RadiometricEncoding& encoding, std::vector<unsigned char>& vecRaw) const
+  {
+    const int nBytes = bUInt16 ? 2 : 4;
+    const int nRowBytes = m_nTileSize * nBytes;
+    vecRaw.assign(size_t(nRowBytes) * m_nTileSize, 0);
+
+    const int x0 = nTileX * m_nTileSize;
+    const int y0 = nTileY * m_nTileSize;
+    const int nWidth = std::min(m_nTileSize, matData.cols - x0);
+    const int nHeight = std::min(m_nTileSize, matData.rows - y0);
+
+    std::vector<unsigned char> vecRow(nRowBytes);
+    for (int y = 0; y < m_nTileSize; y++)
+    {
+      unsigned char* pDst = &vecRaw[size_t(y) * nRowBytes];
+      if (y >= nHeight)
+      {
+        // padding: repeat the last row (compresses to nearly nothing)
+        std::memcpy(pDst, pDst - nRowBytes, nRowBytes);
+        continue;
+      }
+
+      const float* pSrc = matData[y0 + y] + x0;
+      if (!m_bCompression)
+      {
+        // no predictor: little endian samples
+        for (int x = 0; x < m_nTileSize; x++)
+        {
+          const float fValue = pSrc[std::min(x, nWidth - 1)];
+          if (bUInt16)
+          {
+            const unsigned short nValue = encoding.encode(fValue);
+            pDst[2 * x] = (unsigned char)(nValue & 0xFF);
+            pDst[2 * x + 1] = (unsigned char)(nValue >> 8);
+          }
+          else
+          {
+            uint32_t nValue = 0;
+            std::memcpy(&nValue, &fValue, sizeof(nValue));
+            for (int b = 0; b < 4; b++)
+            {
+              pDst[4 * x + b] = (unsigned char)(nValue >> (8 * b));
+            }
+          }
+        }
+      }
+      else if (bUInt16)
+      {
+        // predictor 2: horizontal differencing of the 16 bit values
+        unsigned short nPrev = 0;
+        for (int x = 0; x < m_nTileSize; x++)
+        {
+          unsigned short nValue = encoding.encode(pSrc[std::min(x, nWidth - 1)]);
+          unsigned short nDiff = (unsigned short)(nValue - nPrev);
+          nPrev = nValue;
+          pDst[2 * x] = (unsigned char)(nDiff & 0xFF);
+          pDst[2 * x + 1] = (unsigned char)(nDiff >> 8);
+        }
+      }
+      else
+      {
+        // predictor 3: split into byte planes (most significant first) ...
+        for (int x = 0; x < m_nTileSize; x++)
+        {
+          uint32_t nValue = 0;
+          std::memcpy(&nValue, &pSrc[std::min(x, nWidth - 1)], sizeof(nValue));
+          for (int b = 0; b < 4; b++)
+          {
+            vecRow[b * m_nTileSize + x] = (unsigned char)(nValue >> (8 * (3 - b)));
+          }
+        }
+        // ... and byte wise horizontal differencing
+        pDst[0] = vecRow[0];
+        for (int i = 1; i < nRowBytes; i++)
+        {
+          pDst[i] = (unsigned char)(vecRow[i] - vecRow[i - 1]);
+        }
+      }
+    }
+  }
+
+  // TIFF LZW (msb first, 9...12 bit codes, early change)
+  static void compressLzw(const std::vector<unsigned char>& vecSrc, std::vector<unsigned char>& vecDst)
+  {
+    const int nClear = 256;
+    const int nEoi = 257;
+    const int nHashSize = 8192;
+
+    vecDst.clear();
+    vecDst.reserve(vecSrc.size() / 2 + 16);
+
+    std::vector<int> vecKeys(nHashSize, -1);
+    std::vector<short> vecCodes(nHashSize, 0);
+
+    uint32_t nBitBuffer = 0;
+    int nBitCount = 0;
+    int nWidth = 9;
+    int nNextCode = 258;
+
+    auto put = [&](int nCode)
+    {
+      nBitBuffer = (nBitBuffer << nWidth) | uint32_t(nCode);
+      nBitCount += nWidth;
+      while (nBitCount >= 8)
+      {
+        nBitCount -= 8;
+        vecDst.push_back((unsigned char)(nBitBuffer >> nBitCount));
+      }
+    };
+
+    auto grow = [&]()
+    {
+      nNextCode++;
+      if (nNextCode == 4094)
+      {
+        put(nClear);
+        std::fill(vecKeys.begin(), vecKeys.end(), -1);
+        nWidth = 9;
+        nNextCode = 258;
+      }
+      else if (nNextCode > (1 << nWidth) - 1)
+      {
+        nWidth++;
+      }
+    };
+
+    put(nClear);
+    if (!vecSrc.empty())
+    {
+      int nPrefix = vecSrc[0];
+      for (size_t i = 1; i < vecSrc.size(); i++)
+      {
+        const int nKey = (nPrefix << 8) | vecSrc[i];
+        int nHash = ((nKey * 2654435761u) >> 19) & (nHashSize - 1);
+        while (vecKeys[nHash] != -1 && vecKeys[nHash] != nKey)
+        {
+          nHash = (nHash + 1) & (nHashSize - 1);
+        }
+
+        if (vecKeys[nHash] == nKey)
+        {
+          nPrefix = vecCodes[nHash];
+          continue;
+        }
+
+        put(nPrefix);
+        vecKeys[nHash] = nKey;
+        vecCodes[nHash] = short(nNextCode);
+        grow();
+        nPrefix = vecSrc[i];
+      }
+
+      put(nPrefix);
+      grow();
+    }
+    put(nEoi);
+
+    if (nBitCount > 0)
+    {
+      vecDst.push_back((unsigned char)(nBitBuffer << (8 - nBitCount)));
+    }
+  }
+
+  void writeDirectory(std::ostream& os, std::streamoff nStart, const cv::Size& size, bool bUInt16,
+                      const RadiometricMetaData& metaData,
+                      const std::vector<uint32_t>& vecOffsets,
+                      const std::vector<uint32_t>& vecByteCounts) const
+  {
+    std::ostringstream ossDescription;
+    for (const auto& item : metaData)
+    {
+      ossDescription << item.first << "=" << item.second << "\n";
+    }
+    std::string strDescription = ossDescription.str();
+    strDescription.push_back('\0');
+
+    // values that do not fit into a directory entry are written first (word aligned)
+    if ((os.tellp() - nStart) % 2) os.put(0);
+    const uint32_t nDescriptionOffset = uint32_t(os.tellp() - nStart);
+    os.write(strDescription.data(), strDescription.size());
+    if ((os.tellp() - nStart) % 2) os.put(0);
+
+    const uint32_t nTiles = uint32_t(vecOffsets.size());
+    uint32_t nOffsetsValue = vecOffsets[0];
+    uint32_t nByteCountsValue = vecByteCounts[0];
+    if (nTiles > 1)
+    {
+      nOffsetsValue = uint32_t(os.tellp() - nStart);
+      writeLongs(os, vecOffsets);
+      nByteCountsValue = uint32_t(os.tellp() - nStart);
+      writeLongs(os, vecByteCounts);
+    }
+
+    const uint32_t nDirectoryOffset = uint32_t(os.tellp() - nStart);
+
+    const uint16_t nAscii = 2;
+    const uint16_t nShort = 3;
+    const uint16_t nLong = 4;
+    const uint32_t aEntries[][3] =
+    {
+      { 256, nLong, uint32_t(size.width) },                       // ImageWidth
+      { 257, nLong, uint32_t(size.height) },                      // ImageLength
+      { 258, nShort, bUInt16 ? 16u : 32u },                       // BitsPerSample
+      { 259, nShort, m_bCompression ? 5u : 1u },                  // Compression: LZW / none
+      { 262, nShort, 1 },                                         // PhotometricInterpretation: BlackIsZero
+      { 270, nAscii, nDescriptionOffset },                        // ImageDescription
+      { 277, nShort, 1 },                                         // SamplesPerPixel
+      { 284, nShort, 1 },                                         // PlanarConfiguration: contiguous
+      { 317, nShort, bUInt16 ? 2u : 3u },                         // Predictor
+      { 322, nLong, uint32_t(m_nTileSize) },                      // TileWidth
+      { 323, nLong, uint32_t(m_nTileSize) },                      // TileLength
+      { 324, nLong, nOffsetsValue },                              // TileOffsets
+      { 325, nLong, nByteCountsValue },                           // TileByteCounts
+      { 339, nShort, bUInt16 ? 1u : 3u },                         // SampleFormat: uint / float
+    };
+    // the predictor is only defined for compressed data
+    const uint16_t nEntries = uint16_t(sizeof(aEntries) / sizeof(aEntries[0]) - (m_bCompression ? 0 : 1));
+
+    writeShort(os, nEntries);
+    for (const auto& entry : aEntries)
+    {
+      if (entry[0] == 317 && !m_bCompression) continue;
+
+      uint32_t nCount = 1;
+      if (entry[0] == 270) nCount = uint32_t(strDescription.size());
+      if (entry[0] == 324 || entry[0] == 325) nCount = nTiles;
+
+      writeShort(os, uint16_t(entry[0]));
+      writeShort(os, uint16_t(entry[1]));
+      writeLongs(os, std::vector<uint32_t>(1, nCount));
+      if (entry[1] == nShort)
+      {
+        // short values are left aligned in the value field
+        writeShort(os, uint16_t(entry[2]));
+        writeShort(os, 0);
+      }
+      else
+      {
+        writeLongs(os, std::vector<uint32_t>(1, entry[2]));
+      }
+    }
+    // no further directory
+    writeLongs(os, std::vector<uint32_t>(1, 0));
+    const std::streamoff nEnd = os.tellp();
+
+    // directory offset in the header
+    os.seekp(nStart + 4);
+    writeLongs(os, std::vector<uint32_t>(1, nDirectoryOffset));
+    os.seekp(nEnd);
+
+    if (!os) throw std::runtime_error("RadiometricTiffWriter: write error");
+  }
+
+  static void writeShort(std::ostream& os, uint16_t nValue)
+  {
+    const char aBytes[2] = { char(nValue & 0xFF), char((nValue >> 8) & 0xFF) };
+    os.write(aBytes, sizeof(aBytes));
+  }
+
+  static void writeLongs(std::ostream& os, const std::vector<uint32_t>& vecValues)
+  {
+    for (uint32_t nValue : vecValues)
+    {
+      const char aBytes[4] = { char(nValue & 0xFF), char((nValue >> 8) & 0xFF),
+                               char((nValue >> 16) & 0xFF), char((nValue >> 24) & 0xFF) };
+      os.write(aBytes, sizeof(aBytes));
+    }
+  }
+
+  int m_nTileSize;
+  int m_nThreads;
+  bool m_bCompression;
+};
+
+/**
+*************************************************************************
+encode radiometric data as 16 bit PNG (RadiometricEncoding)
+
+The metadata is stored in tEXt chunks after the image header.
+
+@param [in] matData temperature data in degree Celsius
+@param [in] metaData calibration and measurement parameters
+@param [in] nCompressionLevel zlib level 0...9
+@return PNG file content
+************************************************************************/
+inline std::vector<unsigned char> encodeRadiometricPng(const cv::Mat_<float>& matData, RadiometricMetaData metaData,
+                                                       int nCompressionLevel = 3)
+{
+  const RadiometricEncoding encoding = RadiometricEncoding::forData(matData);
+  encoding.addTo(metaData);
+
+  cv::Mat_<unsigned short> matEncoded(matData.size());
+  for (int y = 0; y < matData.rows; y++)
+  {
+    const float* pSrc = matData[y];
+    unsigned short* pDst = matEncoded[y];
+    for (int x = 0; x < matData.cols; x++)
+    {
+      pDst[x] = encoding.encode(pSrc[x]);
+    }
+  }
+
+  std::vector<unsigned char> vecPng;
+  cv::imencode(".png", matEncoded, vecPng, std::vector<int>{ cv::IMWRITE_PNG_COMPRESSION, nCompressionLevel });
+
+  // crc32 (polynom 0xEDB88320) over chunk type and data
+  auto crc32 = [](const unsigned char* pData, size_t nSize)
+  {
+    uint32_t nCrc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < nSize; i++)
+    {
+      nCrc ^= pData[i];
+      for (int k = 0; k < 8; k++)
+      {
+        nCrc = (nCrc >> 1) ^ (0xEDB88320u & (0u - (nCrc & 1u)));
+      }
+    }
+    return nCrc ^ 0xFFFFFFFFu;
+  };
+
+  auto appendLong = [](std::vector<unsigned char>& vec, uint32_t nValue)
+  {
+    vec.push_back((unsigned char)(nValue >> 24));
+    vec.push_back((unsigned char)(nValue >> 16));
+    vec.push_back((unsigned char)(nValue >> 8));
+    vec.push_back((unsigned char)(nValue));
+  };
+
+  std::vector<unsigned char> vecChunks;
+  for (const auto& item : metaData)
+  {
+    std::vector<unsigned char> vecChunk = { 't', 'E', 'X', 't' };
+    // keywords are limited to 79 characters
+    vecChunk.insert(vecChunk.end(), item.first.begin(), item.first.begin() + std::min<size_t>(item.first.size(), 79));
+    vecChunk.push_back(0);
+    vecChunk.insert(vecChunk.end(), item.second.begin(), item.second.end());
+
+    appendLong(vecChunks, uint32_t(vecChunk.size() - 4));
+    vecChunks.insert(vecChunks.end(), vecChunk.begin(), vecChunk.end());
+    appendLong(vecChunks, crc32(vecChunk.data(), vecChunk.size()));
+  }
+
+  // signature (8 bytes) + IHDR chunk (25 bytes)
+  const size_t nHeaderEnd = 33;
+  vecPng.insert(vecPng.begin() + nHeaderEnd, vecChunks.begin(), vecChunks.end());
+  return vecPng;
+}
+
+#endif
@@ -0,0 +1,430 @@
+/***************************************************************************
+* Copyright: Testo SE & Co. KGaA, Testo-Straße 1, 79849 Lenzkirch
+***************************************************************************/
+/**@file
+@brief<b>Description: </b> in-process camera simulation replaying bmt files
+
+***************************************************************************/
+
+#ifndef IR_API_EXAMPLE_SIMULATED_CAM_H
+#define IR_API_EXAMPLE_SIMULATED_CAM_H
+
+/***************************************************************************
+* Includes
+***************************************************************************/
+
+#include <irapi/Image.h>
+#include <irapi/IrTypes.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <algorithm>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+/**
+**************************************************************************
+@brief Simulated camera with the interface of irapi::Cam
+
+Serves a set of bmt files as camera memory (directory listing, file
+content, previews) and replays their temperature data as live stream
+with a configurable frame rate. Code that is written as template for the
+camera type can run against irapi::Cam or this class, e.g. for load tests
+without hardware.
+
+Live stream timing: frame n is sent at start + n / frame rate. Like the
+real camera the frames are queued if the caller is slower than the
+stream (the delay builds up), setDropLateFrames(true) returns the newest
+frame instead and counts the skipped ones. Frame rate 0 streams as fast
+as the caller polls.
+
+All bmt files are decoded once in the constructor, so the live stream
+only costs a copy of the frame.
+**************************************************************************/
+class SimulatedCam
+{
+public:
+  /**
+  **************************************************************************
+  Constructor
+
+  @param [in] vecFiles bmt files (the file names without path are the
+              names in the simulated camera memory, they have to be unique)
+  @param [in] dFrameRate live stream frame rate in Hz (0 = unlimited)
+  ***************************************************************************/
+  SimulatedCam(const std::vector<std::string>& vecFiles, double dFrameRate = 4.5)
+    : m_dFrameRate(std::max(dFrameRate, 0.0))
+    , m_dBytesPerSecond(0.0)
+    , m_bDropLateFrames(false)
+    , m_bConnected(true)
+    , m_bStreaming(false)
+    , m_nFrame(0)
+    , m_nLastFrame(0)
+    , m_nDroppedFrames(0)
+    , m_dLastLatencyMs(0.0)
+    , m_nSerialNumber(0)
+    , m_nCaptureCount(0)
+  {
+    for (const std::string& strFile : vecFiles)
+    {
+      const size_t nSeparator = strFile.find_last_of("/\\");
+      const std::string strName = (nSeparator == std::string::npos) ? strFile : strFile.substr(nSeparator + 1);
+      if (m_mapFiles.count(strName) != 0)
+      {
+        throw std::runtime_error("SimulatedCam: duplicate file name " + strName);
+      }
+
+      std::ifstream ifs(strFile, std::ios::binary);
+      if (!ifs.is_open())
+      {
+        throw std::runtime_error("SimulatedCam: could not open " + strFile);
+      }
+
+      MemoryFile file;
+      file.vecData.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+
+      irapi::Image image(file.vecData);
+      file.nTimestamp = image.getFileDateTime();
+      m_vecFrames.push_back(decodeFrame(image));
+
+      if (m_strDeviceType.empty())
+      {
+        m_strDeviceType = image.getDeviceName();
+        m_nSerialNumber = image.getDeviceSerialNumber();
+      }
+
+      m_vecFrameNames.push_back(strName);
+      m_mapFiles[strName] = file;
+    }
+
+    if (m_vecFrames.empty())
+    {
+      throw std::runtime_error("SimulatedCam: no bmt files");
+    }
+  }
+
+  ~SimulatedCam()
+  {
+    stopLiveIr();
+  }
+
+  SimulatedCam(const SimulatedCam& other) = delete;
+  SimulatedCam& operator= (const SimulatedCam& rhs) = delete;
+
+  /**************************************************************************
+  * simulation settings
+  ***************************************************************************/
+
+  void setFrameRate(double dFrameRate)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dFrameRate = std::max(dFrameRate, 0.0);
+    restartClock();
+  }
+
+  /**
+  *************************************************************************
+  simulate a limited transfer rate for file content (0 = unlimited)
+  ************************************************************************/
+  void setTransferRate(double dBytesPerSecond)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dBytesPerSecond = std::max(dBytesPerSecond, 0.0);
+  }
+
+  void setDropLateFrames(bool bDropLateFrames)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bDropLateFrames = bDropLateFrames;
+  }
+
+  /**
+  *************************************************************************
+  simulate a lost connection (calls throw irapi::CameraNotConnectedException)
+  ************************************************************************/
+  void setConnected(bool bConnected)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bConnected = bConnected;
+    m_bStreaming = false;
+  }
+
+  /**
+  *************************************************************************
+  @return number of live frames skipped by setDropLateFrames(true)
+  ************************************************************************/
+  uint64_t getDroppedFrames() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nDroppedFrames;
+  }
+
+  /**
+  *************************************************************************
+  @return time between sending and returning the last live frame in ms
+  ************************************************************************/
+  double getLastLatency() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dLastLatencyMs;
+  }
+
+  /**************************************************************************
+  * irapi::Cam interface
+  ***************************************************************************/
+
+  bool isConnected()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bConnected;
+  }
+
+  bool waitUntilConnected(int nTimeoutMs)
+  {
+    const auto timeEnd = Clock::now() + std::chrono::milliseconds(nTimeoutMs);
+    while (!isConnected())
+    {
+      if (Clock::now() >= timeEnd) return false;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return true;
+  }
+
+  bool connect()
+  {
+    return isConnected();
+  }
+
+  uint64_t getDeviceSerialNumber()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    checkConnection();
+    return m_nSerialNumber;
+  }
+
+  std::string getDeviceType()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    checkConnection();
+    return m_strDeviceType;
+  }
+
+  std::map<std::string, uint64_t> listDirectoryContent()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    checkConnection();
+
+    std::map<std::string, uint64_t> mapContent;
+    for (const auto& item : m_mapFiles)
+    {
+      mapContent[item.first] = item.second.nTimestamp;
+    }
+    return mapContent;
+  }
+
+  void removeFile(const std::string& strFileName)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    checkConnection();
+    m_mapFiles.erase(strFileName);
+  }
+
+  std::vector<char> getFileContent(const std::string& strFileName)
+  {
+    std::vector<char> vecData;
+    double dBytesPerSecond = 0.0;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      checkConnection();
+      vecData = findFile(strFileName).vecData;
+      dBytesPerSecond = m_dBytesPerSecond;
+    }
+
+    if (dBytesPerSecond > 0.0)
+    {
+      std::this_thread::sleep_for(std::chrono::duration<double>(vecData.size() / dBytesPerSecond));
+    }
+    return vecData;
+  }
+
+  cv::Mat3b getIrFilePreview(const std::string& strFileName)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    checkConnection();
+    return irapi::Image::getIrImagePreview(findFile(strFileName).vecData);
+  }
+
+  /**
+  *************************************************************************
+  stores the bmt file of the last returned live frame as new file
+  ************************************************************************/
+  void triggerImageCapture()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    checkConnection();
+
+    const std::string& strSource = m_vecFrameNames[m_nLastFrame];
+    auto it = m_mapFiles.find(strSource);
+    if (it == m_mapFiles.end()) return;
+
+    MemoryFile file = it->second;
+    file.nTimestamp = uint64_t(std::chrono::duration_cast<std::chrono::seconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count());
+    m_mapFiles["SIM_CAPTURE_" + std::to_string(++m_nCaptureCount) + ".BMT"] = file;
+  }
+
+  irapi::IrFrame captureLiveIr()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    checkConnection();
+
+    if (!m_bStreaming)
+    {
+      m_bStreaming = true;
+      restartClock();
+    }
+
+    Clock::time_point timeSend = m_timeStart;
+    if (m_dFrameRate > 0.0)
+    {
+      const auto now = Clock::now();
+      if (m_bDropLateFrames)
+      {
+        // skip to the newest frame that was sent already
+        const uint64_t nSent = uint64_t(std::chrono::duration<double>(now - m_timeStart).count() * m_dFrameRate);
+        if (nSent > m_nFrame)
+        {
+          m_nDroppedFrames += nSent - m_nFrame;
+          m_nFrame = nSent;
+        }
+      }
+
+      timeSend = m_timeStart + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(m_nFrame / m_dFrameRate));
+
+      if (timeSend > now)
+      {
+        lock.unlock();
+        std::this_thread::sleep_until(timeSend);
+        lock.lock();
+        checkConnection();
+      }
+    }
+    else
+    {
+      timeSend = Clock::now();
+    }
+
+    m_nLastFrame = size_t(m_nFrame % m_vecFrames.size());
+    const LiveFrame& source = m_vecFrames[m_nLastFrame];
+    m_nFrame++;
+
+    irapi::IrFrame frame;
+    frame.matIrData = source.matIrData.clone();
+    frame.matIrBgr = source.matIrBgr.clone();
+    frame.fScaleMin = source.fScaleMin;
+    frame.fScaleMax = source.fScaleMax;
+    frame.matScaleGradient = source.matScaleGradient;
+
+    m_dLastLatencyMs = std::chrono::duration<double, std::milli>(Clock::now() - timeSend).count();
+    return frame;
+  }
+
+  void stopLiveIr()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bStreaming = false;
+  }
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct MemoryFile
+  {
+    std::vector<char> vecData;
+    uint64_t nTimestamp;
+  };
+
+  struct LiveFrame
+  {
+    cv::Mat_<float> matIrData;
+    cv::Mat3b matIrBgr;
+    float fScaleMin;
+    float fScaleMax;
+    cv::Mat3b matScaleGradient;
+  };
+
+  static LiveFrame decodeFrame(irapi::Image& image)
+  {
+    LiveFrame frame;
+    frame.matIrData = image.getIrImageData();
+    frame.matIrBgr = image.getIrImageBgr();
+    frame.fScaleMin = image.getScaleBottom();
+    frame.fScaleMax = image.getScaleTop();
+
+    // getPaletteColors returns RGB, the live frame gradient is a BGR column
+    cv::Mat3b matColors = image.getPaletteColors(256);
+    cv::cvtColor(matColors.reshape(3, int(matColors.total())), frame.matScaleGradient, cv::COLOR_RGB2BGR);
+    return frame;
+  }
+
+  // called with locked mutex
+  void checkConnection() const
+  {
+    if (!m_bConnected)
+    {
+      throw irapi::CameraNotConnectedException("simulated camera is not connected");
+    }
+  }
+
+  // called with locked mutex
+  const MemoryFile& findFile(const std::string& strFileName) const
+  {
+    auto it = m_mapFiles.find(strFileName);
+    if (it == m_mapFiles.end())
+    {
+      throw irapi::ParameterException("file not found: " + strFileName);
+    }
+    return it->second;
+  }
+
+  // called with locked mutex
+  void restartClock()
+  {
+    m_timeStart = Clock::now();
+    m_nFrame = 0;
+  }
+
+  double m_dFrameRate;
+  double m_dBytesPerSecond;
+  bool m_bDropLateFrames;
+  bool m_bConnected;
+  bool m_bStreaming;
+
+  Clock::time_point m_timeStart;
+
+  // next frame to send, index of the last returned frame
+  uint64_t m_nFrame;
+  size_t m_nLastFrame;
+  uint64_t m_nDroppedFrames;
+  double m_dLastLatencyMs;
+
+  std::string m_strDeviceType;
+  uint64_t m_nSerialNumber;
+  int m_nCaptureCount;
+
+  std::map<std::string, MemoryFile> m_mapFiles;
+  std::vector<LiveFrame> m_vecFrames;
+  std::vector<std::string> m_vecFrameNames;
+
+  mutable std::mutex m_mutex;
+};
+
+#endif
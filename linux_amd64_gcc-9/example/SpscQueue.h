@@ -0,0 +1,291 @@
+/***************************************************************************
+* Copyright: Testo SE & Co. KGaA, Testo-Straße 1, 79849 Lenzkirch
+***************************************************************************/
+/**@file
+@brief<b>Description: </b> bounded lock free single producer single consumer queue
+
+***************************************************************************/
+
+#ifndef IR_API_EXAMPLE_SPSC_QUEUE_H
+#define IR_API_EXAMPLE_SPSC_QUEUE_H
+
+/***************************************************************************
+* Includes
+***************************************************************************/
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+
+/**
+**************************************************************************
+@brief Behaviour of SpscQueue::push if the queue is full
+**************************************************************************/
+enum QueueFullPolicy
+{
+  // the new element is dropped
+  QueueDropNewest,
+
+  // the oldest element in the queue is dropped
+  QueueDropOldest,
+
+  // the producer waits until the consumer takes an element
+  QueueBlock
+};
+
+/**
+**************************************************************************
+@brief Wakeup of threads waiting for a lock free queue
+
+notify() only takes the mutex if a thread is waiting, so the lock free
+path stays free of locks while the other side is busy.
+**************************************************************************/
+class QueueEvent
+{
+public:
+  QueueEvent() : m_nWaiters(0) {}
+
+  QueueEvent(const QueueEvent& other) = delete;
+  QueueEvent& operator= (const QueueEvent& rhs) = delete;
+
+  /**
+  *************************************************************************
+  wakes the waiting threads, call after the change of their condition
+  ************************************************************************/
+  void notify()
+  {
+    // orders the change of the condition before the check for waiters
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_nWaiters.load(std::memory_order_relaxed) == 0) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_condition.notify_all();
+  }
+
+  /**
+  *************************************************************************
+  yields a few times, then blocks until bReady() returns true
+  ************************************************************************/
+  template<typename Predicate>
+  void wait(Predicate bReady)
+  {
+    for (int i = 0; i < nSpins; i++)
+    {
+      if (bReady()) return;
+      std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_nWaiters.fetch_add(1, std::memory_order_relaxed);
+    // pairs with the fence of notify: either notify sees the waiter or
+    // bReady sees the change
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    m_condition.wait(lock, bReady);
+    m_nWaiters.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+private:
+  static const int nSpins = 64;
+
+  std::atomic<int> m_nWaiters;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+};
+
+/**
+**************************************************************************
+@brief Bounded lock free queue for one producer and one consumer thread
+
+Ring buffer with a sequence number per slot (D. Vyukov): push and pop
+only touch the slot and their own position, so producer and consumer do
+not share a lock or a cache line in the common case.
+
+The position of the consumer is advanced with compare and swap, so the
+producer may take the oldest element itself (QueueDropOldest) while the
+consumer is reading. All other calls are reserved to their thread.
+
+Waiting threads (waitForData, push with QueueBlock) spin shortly and then
+block until the other side wakes them, an idle queue costs no CPU time.
+
+T must be default constructible and move assignable.
+**************************************************************************/
+template<typename T>
+class SpscQueue
+{
+public:
+  /**
+  **************************************************************************
+  Constructor
+
+  @param [in] nCapacity maximum number of elements (at least 2, with one
+              slot the sequence numbers of full and empty are the same)
+  ***************************************************************************/
+  explicit SpscQueue(size_t nCapacity)
+    : m_nCapacity(std::max<size_t>(nCapacity, 2))
+    , m_vecSlots(m_nCapacity)
+    , m_nTail(0)
+    , m_aPadding()
+    , m_nHead(0)
+  {
+    for (size_t i = 0; i < m_nCapacity; i++)
+    {
+      m_vecSlots[i].nSequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  SpscQueue(const SpscQueue& other) = delete;
+  SpscQueue& operator= (const SpscQueue& rhs) = delete;
+
+  size_t capacity() const { return m_nCapacity; }
+
+  /**
+  *************************************************************************
+  append an element (producer thread)
+
+  @param [in, out] value element, moved into the queue on success
+  @return false if the queue is full
+  ************************************************************************/
+  bool tryPush(T& value)
+  {
+    const size_t nPos = m_nTail.load(std::memory_order_relaxed);
+    Slot& slot = m_vecSlots[nPos % m_nCapacity];
+    if (slot.nSequence.load(std::memory_order_acquire) != nPos) return false;
+
+    slot.value = std::move(value);
+    slot.nSequence.store(nPos + 1, std::memory_order_release);
+    m_nTail.store(nPos + 1, std::memory_order_relaxed);
+    m_eventData.notify();
+    return true;
+  }
+
+  /**
+  *************************************************************************
+  take the oldest element (consumer thread)
+
+  @param [out] value element
+  @return false if the queue is empty
+  ************************************************************************/
+  bool tryPop(T& value)
+  {
+    size_t nPos = m_nHead.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      Slot& slot = m_vecSlots[nPos % m_nCapacity];
+      const size_t nSequence = slot.nSequence.load(std::memory_order_acquire);
+      if (nSequence != nPos + 1)
+      {
+        // empty, or the other thread took the element
+        if (nSequence == nPos) return false;
+        nPos = m_nHead.load(std::memory_order_relaxed);
+        continue;
+      }
+
+      if (m_nHead.compare_exchange_weak(nPos, nPos + 1, std::memory_order_relaxed))
+      {
+        value = std::move(slot.value);
+        slot.nSequence.store(nPos + m_nCapacity, std::memory_order_release);
+        m_eventSpace.notify();
+        return true;
+      }
+    }
+  }
+
+  /**
+  *************************************************************************
+  waits until the queue holds an element or bCancel() returns true
+  (consumer thread); the thread changing the cancel condition has to call
+  wakeConsumer afterwards
+  ************************************************************************/
+  template<typename Predicate>
+  void waitForData(Predicate bCancel)
+  {
+    m_eventData.wait([this, &bCancel]() { return hasData() || bCancel(); });
+  }
+
+  void wakeConsumer()
+  {
+    m_eventData.notify();
+  }
+
+  /**
+  *************************************************************************
+  append an element, a full queue is handled by policy (producer thread)
+
+  @param [in, out] value element, moved into the queue; with
+                   QueueDropOldest it receives the dropped element
+  @param [in] policy behaviour for a full queue
+  @return false if an element was dropped
+  ************************************************************************/
+  bool push(T& value, QueueFullPolicy policy)
+  {
+    for (;;)
+    {
+      if (tryPush(value)) return true;
+
+      if (policy == QueueDropNewest) return false;
+
+      if (policy == QueueDropOldest)
+      {
+        T oldest;
+        if (tryPop(oldest))
+        {
+          // taking the oldest element frees a slot, only this thread pushes;
+          // the consumer may still be releasing the slot it took before
+          while (!tryPush(value))
+          {
+            std::this_thread::yield();
+          }
+          value = std::move(oldest);
+          return false;
+        }
+      }
+      else
+      {
+        m_eventSpace.wait([this]() { return hasSpace(); });
+      }
+    }
+  }
+
+private:
+  // consumer side
+  bool hasData() const
+  {
+    const size_t nPos = m_nHead.load(std::memory_order_relaxed);
+    return m_vecSlots[nPos % m_nCapacity].nSequence.load(std::memory_order_acquire) == nPos + 1;
+  }
+
+  // producer side
+  bool hasSpace() const
+  {
+    const size_t nPos = m_nTail.load(std::memory_order_relaxed);
+    return m_vecSlots[nPos % m_nCapacity].nSequence.load(std::memory_order_acquire) == nPos;
+  }
+
+  struct Slot
+  {
+    Slot() : nSequence(0), value() {}
+
+    // position + 1 if the slot holds the element of this position
+    std::atomic<size_t> nSequence;
+    T value;
+  };
+
+  const size_t m_nCapacity;
+  std::vector<Slot> m_vecSlots;
+
+  // positions of producer and consumer on separate cache lines
+  std::atomic<size_t> m_nTail;
+  char m_aPadding[64];
+  std::atomic<size_t> m_nHead;
+
+  // signaled by push (for the consumer) and pop (for the producer)
+  QueueEvent m_eventData;
+  QueueEvent m_eventSpace;
+};
+
+#endif
@@ -0,0 +1,137 @@
+/***************************************************************************
+* Copyright: Testo SE & Co. KGaA, Testo-Straße 1, 79849 Lenzkirch
+***************************************************************************/
+/**@file
+@brief<b>Description: </b> motion adaptive temporal noise reduction for live ir frames
+
+***************************************************************************/
+
+#ifndef IR_API_EXAMPLE_TEMPORAL_NOISE_REDUCTION_H
+#define IR_API_EXAMPLE_TEMPORAL_NOISE_REDUCTION_H
+
+/***************************************************************************
+* Includes
+***************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+
+/**
+**************************************************************************
+@brief Temporal noise reduction (recursive filter)
+
+Every pixel is filtered with its own weight:
+
+  out = state + k * (in - state)
+  k   = kMin + (1 - kMin) * min(|in - state| / motion threshold, 1)
+
+Static pixels (small difference, i.e. noise) are averaged over time,
+moving pixels (difference above the motion threshold) pass without delay.
+
+Latency: the output belongs to the current frame, no frame is buffered.
+Static content follows slow temperature changes with a time constant of
+about 1 / kMin frames (strength 0.8: kMin = 0.28, apx. 3.5 frames = 0.8s
+at 4.5Hz). The filter itself costs one pass over the frame.
+
+The state is kept in one buffer that is only allocated if the frame size
+changes.
+**************************************************************************/
+class TemporalNoiseReduction
+{
+public:
+  /**
+  **************************************************************************
+  Constructor
+
+  @param [in] fStrength filter strength 0 (off) ... 1 (strongest)
+  @param [in] fMotionThreshold temperature difference in Kelvin that is
+              treated as motion
+  ***************************************************************************/
+  TemporalNoiseReduction(float fStrength = 0.8f, float fMotionThreshold = 0.5f)
+  {
+    setStrength(fStrength);
+    setMotionThreshold(fMotionThreshold);
+  }
+
+  void setStrength(float fStrength)
+  {
+    m_fMinWeight = 1.0f - 0.9f * std::min(std::max(fStrength, 0.0f), 1.0f);
+  }
+
+  void setMotionThreshold(float fMotionThreshold)
+  {
+    m_fMotionThreshold = std::max(fMotionThreshold, 0.001f);
+  }
+
+  /**
+  *************************************************************************
+  reset the filter state (next frame is passed unfiltered)
+  ************************************************************************/
+  void reset()
+  {
+    m_matState.release();
+  }
+
+  /**
+  *************************************************************************
+  filter a frame
+
+  @param [in] matIn temperature data of the current live frame
+  @param [out] matOut filtered data (may be the same as matIn)
+  ************************************************************************/
+  void apply(const cv::Mat_<float>& matIn, cv::Mat_<float>& matOut)
+  {
+    if (m_matState.size() != matIn.size())
+    {
+      matIn.copyTo(m_matState);
+      if (matOut.data != matIn.data) matIn.copyTo(matOut);
+      return;
+    }
+
+    matOut.create(matIn.size());
+
+    const float fMinWeight = m_fMinWeight;
+    const float fSlope = (1.0f - fMinWeight) / m_fMotionThreshold;
+
+    for (int y = 0; y < matIn.rows; y++)
+    {
+      const float* pIn = matIn[y];
+      float* pState = m_matState[y];
+      float* pOut = matOut[y];
+      int x = 0;
+
+#if CV_SIMD
+      const cv::v_float32 vMinWeight = cv::vx_setall_f32(fMinWeight);
+      const cv::v_float32 vSlope = cv::vx_setall_f32(fSlope);
+      const cv::v_float32 vOne = cv::vx_setall_f32(1.0f);
+      for (; x <= matIn.cols - cv::v_float32::nlanes; x += cv::v_float32::nlanes)
+      {
+        cv::v_float32 vState = cv::vx_load(pState + x);
+        cv::v_float32 vDiff = cv::vx_load(pIn + x) - vState;
+        cv::v_float32 vWeight = cv::v_min(cv::v_muladd(cv::v_abs(vDiff), vSlope, vMinWeight), vOne);
+        vState = cv::v_muladd(vDiff, vWeight, vState);
+        cv::v_store(pState + x, vState);
+        cv::v_store(pOut + x, vState);
+      }
+#endif
+      for (; x < matIn.cols; x++)
+      {
+        float fDiff = pIn[x] - pState[x];
+        float fWeight = std::min(std::abs(fDiff) * fSlope + fMinWeight, 1.0f);
+        pState[x] += fDiff * fWeight;
+        pOut[x] = pState[x];
+      }
+    }
+  }
+
+private:
+  float m_fMinWeight;
+  float m_fMotionThreshold;
+
+  cv::Mat_<float> m_matState;
+};
+
+#endif
@@ -0,0 +1,231 @@
+/***************************************************************************
+* Copyright: Testo SE & Co. KGaA, Testo-Straße 1, 79849 Lenzkirch
+***************************************************************************/
+/**@file
+@brief<b>Description: </b> fast lossless codec for 16 bit thermal frames
+
+***************************************************************************/
+
+#ifndef IR_API_EXAMPLE_THERMAL_FRAME_CODEC_H
+#define IR_API_EXAMPLE_THERMAL_FRAME_CODEC_H
+
+/***************************************************************************
+* Includes
+***************************************************************************/
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+
+#include <opencv2/core/core.hpp>
+
+/**
+**************************************************************************
+@brief Lossless codec for 16 bit thermal frames
+
+Every pixel is predicted from its neighbours with the median edge
+detector of LOCO-I / JPEG-LS:
+
+  c b          pred = min(a, b)    if c >= max(a, b)
+  a x                 max(a, b)    if c <= min(a, b)
+                      a + b - c    otherwise
+
+The residuals are zigzag mapped to unsigned values and Rice coded in
+blocks of 16 values. Every block starts with its Rice parameter (5 bit),
+residuals with a quotient >= 24 are escaped (24 one bits + 17 bit value).
+
+Thermal frames are smooth with sensor noise of a few digits, so the
+residuals are small; a 160x120 centi Kelvin frame typically needs 5-7
+bits per pixel. The codec works on one frame without state, so frames can
+be compressed in parallel and decoded in random order.
+**************************************************************************/
+class ThermalFrameCodec
+{
+public:
+  /**
+  *************************************************************************
+  compress a frame
+
+  @param [in] matFrame frame
+  @param [out] vecData compressed data (replaced)
+  ************************************************************************/
+  static void compress(const cv::Mat_<unsigned short>& matFrame, std::vector<unsigned char>& vecData)
+  {
+    vecData.clear();
+    vecData.reserve(matFrame.total() * sizeof(unsigned short) / 2 + 16);
+
+    std::vector<uint32_t> vecResiduals(matFrame.total());
+    uint32_t* pResidual = vecResiduals.data();
+    for (int y = 0; y < matFrame.rows; y++)
+    {
+      const unsigned short* pRow = matFrame[y];
+      const unsigned short* pPrev = (y > 0) ? matFrame[y - 1] : nullptr;
+      for (int x = 0; x < matFrame.cols; x++)
+      {
+        const int nDiff = int(pRow[x]) - predict(pRow, pPrev, x);
+        *pResidual++ = (uint32_t(nDiff) << 1) ^ uint32_t(nDiff >> 31);
+      }
+    }
+
+    BitWriter writer(vecData);
+    const size_t nTotal = vecResiduals.size();
+    for (size_t nStart = 0; nStart < nTotal; nStart += nBlockSize)
+    {
+      const size_t nEnd = std::min(nStart + nBlockSize, nTotal);
+
+      uint64_t nSum = 0;
+      for (size_t i = nStart; i < nEnd; i++) nSum += vecResiduals[i];
+
+      // Rice parameter: k with 2^k apx. the mean residual
+      uint32_t k = 0;
+      while (k < nMaxParameter && (uint64_t(nEnd - nStart) << (k + 1)) <= nSum) k++;
+      writer.put(k, 5);
+
+      for (size_t i = nStart; i < nEnd; i++)
+      {
+        const uint32_t nValue = vecResiduals[i];
+        const uint32_t nQuotient = nValue >> k;
+        if (nQuotient < nEscape)
+        {
+          writer.put(((1u << nQuotient) - 1u) << 1, nQuotient + 1);
+          if (k > 0) writer.put(nValue & ((1u << k) - 1u), k);
+        }
+        else
+        {
+          writer.put((1u << nEscape) - 1u, nEscape);
+          writer.put(nValue, 17);
+        }
+      }
+    }
+    writer.flush();
+  }
+
+  /**
+  *************************************************************************
+  decompress a frame (throws std::runtime_error for corrupt data)
+
+  @param [in] pData compressed data
+  @param [in] nSize size of the compressed data
+  @param [in, out] matFrame frame, must have the size of the frame
+  ************************************************************************/
+  static void decompress(const unsigned char* pData, size_t nSize, cv::Mat_<unsigned short>& matFrame)
+  {
+    BitReader reader(pData, nSize);
+
+    const size_t nTotal = matFrame.total();
+    size_t nIndex = 0;
+    size_t nBlockEnd = 0;
+    uint32_t k = 0;
+
+    for (int y = 0; y < matFrame.rows; y++)
+    {
+      unsigned short* pRow = matFrame[y];
+      const unsigned short* pPrev = (y > 0) ? matFrame[y - 1] : nullptr;
+      for (int x = 0; x < matFrame.cols; x++, nIndex++)
+      {
+        if (nIndex == nBlockEnd)
+        {
+          k = reader.get(5);
+          nBlockEnd = std::min(nIndex + nBlockSize, nTotal);
+        }
+
+        uint32_t nQuotient = 0;
+        while (nQuotient < nEscape && reader.get(1)) nQuotient++;
+
+        const uint32_t nValue = (nQuotient < nEscape)
+          ? ((nQuotient << k) | (k > 0 ? reader.get(k) : 0u))
+          : reader.get(17);
+
+        const int nDiff = int(nValue >> 1) ^ -int(nValue & 1u);
+        pRow[x] = (unsigned short)(predict(pRow, pPrev, x) + nDiff);
+      }
+    }
+
+    if (reader.overrun())
+    {
+      throw std::runtime_error("ThermalFrameCodec: corrupt data");
+    }
+  }
+
+private:
+  static const size_t nBlockSize = 16;
+  static const uint32_t nMaxParameter = 16;
+  static const uint32_t nEscape = 24;
+
+  static int predict(const unsigned short* pRow, const unsigned short* pPrev, int x)
+  {
+    if (!pPrev) return (x > 0) ? pRow[x - 1] : 0;
+    if (x == 0) return pPrev[0];
+
+    const int a = pRow[x - 1];
+    const int b = pPrev[x];
+    const int c = pPrev[x - 1];
+    if (c >= std::max(a, b)) return std::min(a, b);
+    if (c <= std::min(a, b)) return std::max(a, b);
+    return a + b - c;
+  }
+
+  // msb first bit stream
+  class BitWriter
+  {
+  public:
+    explicit BitWriter(std::vector<unsigned char>& vecData) : m_vecData(vecData), m_nBuffer(0), m_nBits(0) {}
+
+    // nBits <= 32
+    void put(uint32_t nValue, uint32_t nBits)
+    {
+      m_nBuffer = (m_nBuffer << nBits) | nValue;
+      m_nBits += nBits;
+      while (m_nBits >= 8)
+      {
+        m_nBits -= 8;
+        m_vecData.push_back((unsigned char)(m_nBuffer >> m_nBits));
+      }
+    }
+
+    void flush()
+    {
+      if (m_nBits > 0) put(0, 8 - m_nBits);
+    }
+
+  private:
+    std::vector<unsigned char>& m_vecData;
+    uint64_t m_nBuffer;
+    uint32_t m_nBits;
+  };
+
+  class BitReader
+  {
+  public:
+    BitReader(const unsigned char* pData, size_t nSize)
+      : m_pData(pData), m_nSize(nSize), m_nPos(0), m_nBuffer(0), m_nBits(0), m_bOverrun(false) {}
+
+    // nBits <= 32
+    uint32_t get(uint32_t nBits)
+    {
+      while (m_nBits < nBits)
+      {
+        uint32_t nByte = 0;
+        if (m_nPos < m_nSize) nByte = m_pData[m_nPos++];
+        else m_bOverrun = true;
+        m_nBuffer = (m_nBuffer << 8) | nByte;
+        m_nBits += 8;
+      }
+      m_nBits -= nBits;
+      return uint32_t(m_nBuffer >> m_nBits) & uint32_t((uint64_t(1) << nBits) - 1u);
+    }
+
+    bool overrun() const { return m_bOverrun; }
+
+  private:
+    const unsigned char* m_pData;
+    size_t m_nSize;
+    size_t m_nPos;
+    uint64_t m_nBuffer;
+    uint32_t m_nBits;
+    bool m_bOverrun;
+  };
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include <irapi/Image.h>
+
+#include "HotRegionLabeling.h"
+
+#include <string>
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+bool existsFile(const std::string& strFilename)
+{
+  std::ifstream ifs(strFilename, std::ifstream::in);
+  return ifs.is_open();
+}
+
+int main(int argc, char* argv[])
+{
+  // This program extracts hot regions from an ir image
+  // call parameter: [bmt file] [threshold in degree Celsius]
+  // (default threshold: 80% between minimal and maximal temperature)
+
+  std::string strBmtFile = (argc > 1) ? argv[1] : "IR_EXAMPLE.BMT";
+  if (!existsFile(strBmtFile))
+  {
+    std::cout << "Could not open BMT file: " << strBmtFile << std::endl;
+    std::cout << "Please provide a bmt file as call parameter.\n";
+    return -1;
+  }
+
+  irapi::Image image(strBmtFile);
+  cv::Mat_<float> matData(image.getIrImageData());
+
+  double dMin = 0.0;
+  double dMax = 0.0;
+  cv::minMaxLoc(matData, &dMin, &dMax);
+  float fThreshold = (argc > 2) ? float(std::atof(argv[2])) : float(dMin + 0.8 * (dMax - dMin));
+
+  const int nIterations = 100;
+
+  HotRegionLabeling labeling;
+  labeling.setMinArea(4);
+  std::vector<HotRegion> vecRegions;
+  int64 nTicks = cv::getTickCount();
+  for (int i = 0; i < nIterations; i++)
+  {
+    labeling.label(matData, fThreshold, vecRegions);
+  }
+  double dLabelingMs = (cv::getTickCount() - nTicks) * 1000.0 / cv::getTickFrequency() / nIterations;
+
+  // reference: threshold + opencv labeling with statistics
+  cv::Mat1b matMask;
+  cv::Mat matLabels, matStats, matCentroids;
+  int nComponents = 0;
+  nTicks = cv::getTickCount();
+  for (int i = 0; i < nIterations; i++)
+  {
+    cv::compare(matData, fThreshold, matMask, cv::CMP_GE);
+    nComponents = cv::connectedComponentsWithStats(matMask, matLabels, matStats, matCentroids, 8) - 1;
+  }
+  double dOpenCvMs = (cv::getTickCount() - nTicks) * 1000.0 / cv::getTickFrequency() / nIterations;
+
+  std::cout << "threshold           : " << fThreshold << " Grad Celsius" << std::endl;
+  std::cout << "HotRegionLabeling   : " << dLabelingMs << " ms, " << vecRegions.size()
+    << " regions (min area 4)" << std::endl;
+  std::cout << "opencv (incl. mask) : " << dOpenCvMs << " ms, " << nComponents << " regions" << std::endl;
+
+  for (size_t i = 0; i < vecRegions.size(); i++)
+  {
+    const HotRegion& region = vecRegions[i];
+    std::cout << "region " << i << ": area " << region.nArea
+      << " center (" << region.ptCenter.x << ", " << region.ptCenter.y << ")"
+      << " elongation " << region.getElongation()
+      << " max " << region.fMaxValue << " at (" << region.ptMax.x << ", " << region.ptMax.y << ")"
+      << " mean " << region.fMeanValue << std::endl;
+  }
+
+  std::cout << "\nPress ENTER to exit!\n>";
+  std::cin.ignore();
+}
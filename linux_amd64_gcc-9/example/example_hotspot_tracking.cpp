@@ -0,0 +1,83 @@
+#include <irapi/Cam.h>
+
+#include "HotRegionTracker.h"
+
+#include <string>
+#include <cstdlib>
+#include <chrono>
+#include <iostream>
+
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+int main(int argc, char* argv[])
+{
+  // This program tracks regions above a temperature threshold in the live stream
+  // call parameter: [threshold in degree Celsius] [cpu budget per frame in ms]
+
+  float fThreshold = (argc > 1) ? float(std::atof(argv[1])) : 40.0f;
+  double dBudgetMs = (argc > 2) ? std::atof(argv[2]) : 20.0;
+
+  irapi::Cam cam;
+  if (!cam.waitUntilConnected(6000))
+  {
+    std::cout << "Could not connect to a camera! --> end programm here\n\n";
+    return -1;
+  }
+
+  std::cout << "Press any key to end live view! (fokus stream window)" << std::endl;
+
+  const char* szWindowName = "Hot region tracking";
+  HotRegionTracker tracker(fThreshold, dBudgetMs);
+  const auto timeStart = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < 1000; i++)
+  {
+    irapi::IrFrame frame;
+
+    try
+    {
+      frame = cam.captureLiveIr();
+    }
+    catch (std::exception& e)
+    {
+      // camera was disconnected?
+      std::cout << "got error: " << e.what();
+      return -1;
+    }
+
+    const double dTimestamp = std::chrono::duration<double>(std::chrono::steady_clock::now() - timeStart).count();
+    const std::vector<HotTrack>& vecTracks = tracker.update(frame.matIrData, dTimestamp);
+
+    cv::Mat3b matDisplay = frame.matIrBgr.clone();
+    for (const HotTrack& track : vecTracks)
+    {
+      if (track.nMissed > 0) continue;
+
+      cv::rectangle(matDisplay, track.region.rectBoundingBox, cv::Scalar(255, 255, 255));
+      cv::putText(matDisplay, std::to_string(track.nId), track.region.rectBoundingBox.tl(),
+                  cv::FONT_HERSHEY_SIMPLEX, 0.4, cv::Scalar(255, 255, 255));
+
+      // trajectory of the center
+      for (size_t n = 1; n < track.deqTrajectory.size(); n++)
+      {
+        cv::line(matDisplay, track.deqTrajectory[n - 1].ptCenter, track.deqTrajectory[n].ptCenter,
+                 cv::Scalar(255, 255, 255));
+      }
+
+      std::cout << "id " << track.nId << ": max " << track.region.fMaxValue
+        << " mean " << track.region.fMeanValue << " area " << track.region.nArea
+        << " (max of track " << track.fMaxValue << ", frames " << track.nHits << ")" << std::endl;
+    }
+    std::cout << "frame " << i << ": " << tracker.getLastProcessingTime() << " ms (labeling "
+      << tracker.getLastLabelingTime() << " ms, matching " << tracker.getLastMatchingTime()
+      << " ms), region limit " << tracker.getRegionLimit() << ", frame interval "
+      << tracker.getFrameInterval() << std::endl;
+
+    cv::imshow(szWindowName, matDisplay);
+    if (cv::waitKey(10) != -1) break; // end loop early
+  }
+
+  cam.stopLiveIr();
+  cv::destroyAllWindows();
+}
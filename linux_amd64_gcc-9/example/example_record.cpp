@@ -0,0 +1,104 @@
+#include <irapi/Cam.h>
+
+#include "LiveRecording.h"
+#include "SimulatedCam.h"
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+
+/**
+*************************************************************************
+records nFrames live frames of a camera (irapi::Cam or SimulatedCam)
+************************************************************************/
+template <typename CamType>
+void recordLive(CamType& cam, const std::string& strPath, int nFrames)
+{
+  LiveRecordingOptions options;
+  options.bCompression = true;
+  // keep the newest frames if the disk can not keep up
+  options.queuePolicy = QueueDropOldest;
+  options.metaData.push_back(std::make_pair("Device", cam.getDeviceType()));
+  options.metaData.push_back(std::make_pair("SerialNumber", std::to_string(cam.getDeviceSerialNumber())));
+
+  LiveRecorder recorder(strPath, options);
+  for (int i = 0; i < nFrames; i++)
+  {
+    recorder.addFrame(cam.captureLiveIr());
+  }
+  cam.stopLiveIr();
+  recorder.close();
+
+  std::cout << "recorded : " << recorder.getWrittenFrames() << " frames, dropped: "
+    << recorder.getDroppedFrames() << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  // This program records the live stream of a camera and replays the
+  // recording faster than real time
+  // call parameter: <recording file> [frames] [camera | bmt file ...]
+  // without bmt files a simulated camera with IR_EXAMPLE.BMT is used
+
+  if (argc < 2)
+  {
+    std::cout << "usage: example_record <recording file> [frames] [camera | bmt file ...]\n";
+    return -1;
+  }
+
+  const std::string strPath = argv[1];
+  const int nFrames = (argc > 2) ? std::max(std::atoi(argv[2]), 1) : 50;
+
+  try
+  {
+    if (argc > 3 && std::string(argv[3]) == "camera")
+    {
+      irapi::Cam cam;
+      if (!cam.waitUntilConnected(6000))
+      {
+        std::cout << "Could not connect to a camera! --> end programm here\n\n";
+        return -1;
+      }
+      recordLive(cam, strPath, nFrames);
+    }
+    else
+    {
+      std::vector<std::string> vecFiles(argv + std::min(argc, 3), argv + argc);
+      if (vecFiles.empty())
+      {
+        vecFiles.push_back("IR_EXAMPLE.BMT");
+      }
+      SimulatedCam cam(vecFiles);
+      recordLive(cam, strPath, nFrames);
+    }
+
+    // offline processing as fast as possible
+    LiveReplay replay(strPath, 0.0);
+    std::cout << "replay   : " << replay.getFrameCount() << " frames, "
+      << replay.getTimestamp(replay.getFrameCount() - 1) << " s recording time" << std::endl;
+    for (const auto& item : replay.getMetaData())
+    {
+      std::cout << "  " << item.first << " = " << item.second << std::endl;
+    }
+
+    int64 nTicks = cv::getTickCount();
+    double dMax = -1000.0;
+    while (replay.isConnected())
+    {
+      irapi::IrFrame frame = replay.captureLiveIr();
+      double dFrameMax = 0.0;
+      cv::minMaxLoc(frame.matIrData, nullptr, &dFrameMax);
+      dMax = std::max(dMax, dFrameMax);
+    }
+    double dMs = (cv::getTickCount() - nTicks) * 1000.0 / cv::getTickFrequency();
+    std::cout << "processed in " << dMs << " ms, maximal temperature: " << dMax << " Grad Celsius" << std::endl;
+  }
+  catch (std::exception& e)
+  {
+    std::cout << "got error: " << e.what() << std::endl;
+    return -1;
+  }
+
+  return 0;
+}
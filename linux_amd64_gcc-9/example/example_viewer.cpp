@@ -0,0 +1,205 @@
+#include <irapi/Image.h>
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include <opencv2/highgui/highgui.hpp>
+
+/**
+**************************************************************************
+@brief Progressive image loader
+
+load() returns the preview that is stored in the file immediately
+(irapi::Image::getIrImagePreview only reads the embedded jpeg) and opens
+the full radiometric image on a background thread. Opening super
+resolution images is the expensive part and does not block the caller.
+
+Only the latest request is processed: a new request replaces a pending one
+and the result of an already running request is dropped (cancel). The
+running irapi::Image construction itself can not be interrupted.
+**************************************************************************/
+class ProgressiveImageLoader
+{
+public:
+  typedef std::function<void(const std::string& strFileName, const cv::Mat3b& matBgr,
+                             const cv::Mat_<float>& matData)> ReadyCallback;
+
+  ProgressiveImageLoader()
+    : m_nRequestId(0)
+    , m_bRunning(true)
+    , m_bPending(false)
+    , m_thdWorker(&ProgressiveImageLoader::worker_loop, this)
+  {
+  }
+
+  ~ProgressiveImageLoader()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_bRunning = false;
+      m_bPending = false;
+    }
+    m_cond.notify_one();
+    m_thdWorker.join();
+  }
+
+  ProgressiveImageLoader(const ProgressiveImageLoader& other) = delete;
+  ProgressiveImageLoader& operator= (const ProgressiveImageLoader& rhs) = delete;
+
+  /**
+  *************************************************************************
+  request an image
+
+  @param [in] strFileName bmt file
+  @param [in] callback called from the worker thread when the full image is
+              ready (without lock, a cancel during the call does not stop it)
+  @return preview image (BGR)
+  ************************************************************************/
+  cv::Mat3b load(const std::string& strFileName, ReadyCallback callback)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      ++m_nRequestId;
+      m_strFileName = strFileName;
+      m_callback = callback;
+      m_bPending = true;
+    }
+    m_cond.notify_one();
+
+    return irapi::Image::getIrImagePreview(strFileName);
+  }
+
+  /**
+  *************************************************************************
+  cancel the current request (e.g. user navigates away)
+  ************************************************************************/
+  void cancel()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_nRequestId;
+    m_bPending = false;
+  }
+
+private:
+  void worker_loop()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+      m_cond.wait(lock, [this] { return m_bPending || !m_bRunning; });
+      if (!m_bRunning) return;
+
+      const uint64_t nRequestId = m_nRequestId;
+      const std::string strFileName = m_strFileName;
+      const ReadyCallback callback = m_callback;
+      m_bPending = false;
+      lock.unlock();
+
+      cv::Mat3b matBgr;
+      cv::Mat_<float> matData;
+      try
+      {
+        irapi::Image image(strFileName);
+        if (m_nRequestId == nRequestId)
+        {
+          matBgr = image.getIrImageBgr();
+          matData = image.getIrImageData();
+        }
+      }
+      catch (std::exception& e)
+      {
+        std::cout << "Error open BMT file: " << e.what() << std::endl;
+      }
+
+      // the callback runs without the lock, it may call load() or cancel()
+      if (m_nRequestId == nRequestId && !matBgr.empty())
+      {
+        callback(strFileName, matBgr, matData);
+      }
+      lock.lock();
+    }
+  }
+
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+
+  std::atomic<uint64_t> m_nRequestId;
+  bool m_bRunning;
+  bool m_bPending;
+  std::string m_strFileName;
+  ReadyCallback m_callback;
+
+  std::thread m_thdWorker;
+};
+
+int main(int argc, char* argv[])
+{
+  // This program shows the preview of an image at once and replaces it
+  // with the full radiometric image as soon as it is loaded.
+  // Any key shows the next image (and cancels the current one), ESC ends the program.
+
+  std::vector<std::string> vecFiles(argv + 1, argv + argc);
+  if (vecFiles.empty())
+  {
+    vecFiles.push_back("IR_EXAMPLE.BMT");
+  }
+
+  const char szWindowName[] = "PROGRESSIVE VIEWER";
+
+  std::mutex mutexReady;
+  cv::Mat3b matReady;
+  std::string strReady;
+
+  ProgressiveImageLoader loader;
+
+  for (size_t i = 0; i < vecFiles.size(); i++)
+  {
+    int64 nStart = cv::getTickCount();
+    cv::Mat3b matPreview;
+    try
+    {
+      matPreview = loader.load(vecFiles[i], [&](const std::string& strFileName, const cv::Mat3b& matBgr,
+                                                const cv::Mat_<float>&)
+      {
+        std::lock_guard<std::mutex> lock(mutexReady);
+        strReady = strFileName;
+        matReady = matBgr;
+      });
+    }
+    catch (std::exception& e)
+    {
+      std::cout << "Error open BMT file: " << e.what() << std::endl;
+      continue;
+    }
+
+    std::cout << vecFiles[i] << ": preview after "
+      << (cv::getTickCount() - nStart) * 1000.0 / cv::getTickFrequency() << " ms" << std::endl;
+    cv::imshow(szWindowName, matPreview);
+
+    int nKey(-1);
+    while (nKey == -1)
+    {
+      nKey = cv::waitKey(10);
+
+      std::lock_guard<std::mutex> lock(mutexReady);
+      if (!matReady.empty() && strReady == vecFiles[i])
+      {
+        std::cout << vecFiles[i] << ": full image after "
+          << (cv::getTickCount() - nStart) * 1000.0 / cv::getTickFrequency() << " ms" << std::endl;
+        cv::imshow(szWindowName, matReady);
+        matReady.release();
+      }
+    }
+
+    loader.cancel();
+    if (nKey == 27) break;
+  }
+
+  cv::destroyAllWindows();
+}
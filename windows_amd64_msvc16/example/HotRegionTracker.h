@@ -0,0 +1,362 @@
+/***************************************************************************
+* Copyright: Testo SE & Co. KGaA, Testo-Straße 1, 79849 Lenzkirch
+***************************************************************************/
+/**@file
+@brief<b>Description: </b> tracking of hot regions across live ir frames
+
+***************************************************************************/
+
+#ifndef IR_API_EXAMPLE_HOT_REGION_TRACKER_H
+#define IR_API_EXAMPLE_HOT_REGION_TRACKER_H
+
+/***************************************************************************
+* Includes
+***************************************************************************/
+
+#include "HotRegionLabeling.h"
+
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <opencv2/core/core.hpp>
+
+/**
+**************************************************************************
+@brief One point of a track trajectory
+**************************************************************************/
+struct HotTrackPoint
+{
+  // input frame number (counted by HotRegionTracker::update)
+  uint64_t nFrame;
+  double dTimestamp;
+  cv::Point2f ptCenter;
+  float fMaxValue;
+  float fMeanValue;
+};
+
+/**
+**************************************************************************
+@brief Tracked hot region
+**************************************************************************/
+struct HotTrack
+{
+  // stable id (unique for the lifetime of the tracker)
+  int nId;
+
+  // region found in the last frame it was visible
+  HotRegion region;
+
+  // number of processed frames the region was found
+  int nHits;
+
+  // number of input frames since the region was found the last time
+  // (0 = visible), updated on processed frames
+  int nMissed;
+
+  // temperature statistics over the whole track
+  float fMaxValue;
+  float fMinValue;
+
+  std::deque<HotTrackPoint> deqTrajectory;
+};
+
+/**
+**************************************************************************
+@brief Hot region tracker
+
+Segments every frame with HotRegionLabeling and assigns the regions to the
+tracks of the previous frames (greedy nearest neighbour on the predicted
+center, gated by the region size). Unmatched regions open new tracks,
+tracks that are not found for more than nMaxMissed input frames are
+removed. Velocity and misses are counted in input frames, so prediction
+and track lifetime do not depend on the frame interval below.
+
+CPU budget: the labeling costs one pass over the frame, the matching cost
+depends on the number of regions; both are measured separately.
+- If labeling and matching together exceed the budget per frame, only
+  every n-th frame is processed (frame interval, up to nMaxFrameInterval).
+  The tracks are kept unchanged on the skipped frames.
+- If the matching alone takes more than half of the budget, the number of
+  regions that are tracked (largest first) is reduced; it grows again
+  while the matching stays below a quarter of the budget.
+Both recover when the processing time drops.
+**************************************************************************/
+class HotRegionTracker
+{
+public:
+  /**
+  **************************************************************************
+  Constructor
+
+  @param [in] fThreshold temperature threshold for hot regions
+  @param [in] dBudgetMs CPU budget per frame in ms
+  ***************************************************************************/
+  HotRegionTracker(float fThreshold, double dBudgetMs = 20.0)
+    : m_fThreshold(fThreshold)
+    , m_dBudgetMs(dBudgetMs)
+    , m_nMaxRegions(64)
+    , m_nRegionLimit(64)
+    , m_nMaxMissed(5)
+    , m_nTrajectoryLength(100)
+    , m_fGateDistance(5.0f)
+    , m_nNextId(1)
+    , m_dLastMs(0.0)
+    , m_dLabelMs(0.0)
+    , m_dMatchMs(0.0)
+    , m_nFrameInterval(1)
+    , m_nSkippedFrames(0)
+    , m_nFrame(0)
+  {
+    m_labeling.setMinArea(4);
+  }
+
+  void setThreshold(float fThreshold) { m_fThreshold = fThreshold; }
+  void setMinArea(int nMinArea) { m_labeling.setMinArea(nMinArea); }
+  void setMaxMissed(int nMaxMissed) { m_nMaxMissed = std::max(nMaxMissed, 0); }
+  void setTrajectoryLength(int nLength) { m_nTrajectoryLength = std::max(nLength, 1); }
+
+  /**
+  *************************************************************************
+  set the maximal number of tracked regions
+  ************************************************************************/
+  void setMaxRegions(int nMaxRegions)
+  {
+    m_nMaxRegions = std::max(nMaxRegions, 1);
+    m_nRegionLimit = m_nMaxRegions;
+  }
+
+  /**
+  *************************************************************************
+  process a frame
+
+  @param [in] matData temperature data of the frame
+  @param [in] dTimestamp frame time in seconds
+  @return all tracks (visible and recently lost)
+  ************************************************************************/
+  const std::vector<HotTrack>& update(const cv::Mat_<float>& matData, double dTimestamp)
+  {
+    m_nFrame++;
+    if (++m_nSkippedFrames < m_nFrameInterval)
+    {
+      m_dLastMs = 0.0;
+      return m_vecTracks;
+    }
+    m_nSkippedFrames = 0;
+
+    const int64 nStart = cv::getTickCount();
+
+    m_labeling.label(matData, m_fThreshold, m_vecRegions);
+    if (int(m_vecRegions.size()) > m_nRegionLimit)
+    {
+      m_vecRegions.resize(m_nRegionLimit);
+    }
+
+    const int64 nLabeled = cv::getTickCount();
+    match();
+
+    // update matched tracks, age the others
+    for (size_t t = 0; t < m_vecTracks.size(); t++)
+    {
+      HotTrack& track = m_vecTracks[t];
+      const int nRegion = m_vecTrackMatch[t];
+      if (nRegion < 0)
+      {
+        track.nMissed = int(m_nFrame - track.deqTrajectory.back().nFrame);
+        continue;
+      }
+      updateTrack(track, m_vecRegions[nRegion], dTimestamp);
+    }
+
+    m_vecTracks.erase(std::remove_if(m_vecTracks.begin(), m_vecTracks.end(),
+      [this](const HotTrack& track) { return track.nMissed > m_nMaxMissed; }), m_vecTracks.end());
+
+    // new tracks for unmatched regions
+    for (size_t r = 0; r < m_vecRegions.size(); r++)
+    {
+      if (m_vecRegionMatched[r]) continue;
+
+      HotTrack track;
+      track.nId = m_nNextId++;
+      track.nHits = 0;
+      track.nMissed = 0;
+      track.fMaxValue = m_vecRegions[r].fMaxValue;
+      track.fMinValue = m_vecRegions[r].fMinValue;
+      updateTrack(track, m_vecRegions[r], dTimestamp);
+      m_vecTracks.push_back(track);
+    }
+
+    const int64 nEnd = cv::getTickCount();
+    m_dLabelMs = (nLabeled - nStart) * 1000.0 / cv::getTickFrequency();
+    m_dMatchMs = (nEnd - nLabeled) * 1000.0 / cv::getTickFrequency();
+    m_dLastMs = m_dLabelMs + m_dMatchMs;
+    adaptToBudget();
+
+    return m_vecTracks;
+  }
+
+  const std::vector<HotTrack>& getTracks() const { return m_vecTracks; }
+
+  /**
+  *************************************************************************
+  @return processing time of the last frame in ms (0 if it was skipped)
+  ************************************************************************/
+  double getLastProcessingTime() const { return m_dLastMs; }
+
+  /**
+  *************************************************************************
+  @return labeling and matching time of the last processed frame in ms
+  ************************************************************************/
+  double getLastLabelingTime() const { return m_dLabelMs; }
+  double getLastMatchingTime() const { return m_dMatchMs; }
+
+  /**
+  *************************************************************************
+  @return current number of regions that are tracked (budget control)
+  ************************************************************************/
+  int getRegionLimit() const { return m_nRegionLimit; }
+
+  /**
+  *************************************************************************
+  @return every n-th frame is processed (budget control)
+  ************************************************************************/
+  int getFrameInterval() const { return m_nFrameInterval; }
+
+private:
+  static const int nMaxFrameInterval = 16;
+
+  void adaptToBudget()
+  {
+    // labeling: the cost per frame is spread over the frame interval
+    if (m_dLastMs > m_dBudgetMs * m_nFrameInterval)
+    {
+      m_nFrameInterval = std::min(int(nMaxFrameInterval), m_nFrameInterval + 1);
+    }
+    else if (m_nFrameInterval > 1 && m_dLastMs < m_dBudgetMs * (m_nFrameInterval - 1) / 2.0)
+    {
+      m_nFrameInterval--;
+    }
+
+    // matching: only the regions make it expensive
+    if (m_dMatchMs > m_dBudgetMs / 2.0)
+    {
+      m_nRegionLimit = std::max(1, m_nRegionLimit / 2);
+    }
+    else if (m_dMatchMs < m_dBudgetMs / 4.0 && m_nRegionLimit < m_nMaxRegions)
+    {
+      m_nRegionLimit++;
+    }
+  }
+
+  // greedy assignment of regions to tracks by increasing distance
+  void match()
+  {
+    m_vecTrackMatch.assign(m_vecTracks.size(), -1);
+    m_vecRegionMatched.assign(m_vecRegions.size(), false);
+    m_vecCandidates.clear();
+
+    for (size_t t = 0; t < m_vecTracks.size(); t++)
+    {
+      const HotTrack& track = m_vecTracks[t];
+      const cv::Point2f ptPredicted = predict(track, m_nFrame);
+      const cv::Rect& rect = track.region.rectBoundingBox;
+      const float fGate = std::max(m_fGateDistance, 0.5f * float(std::max(rect.width, rect.height)));
+
+      for (size_t r = 0; r < m_vecRegions.size(); r++)
+      {
+        const cv::Point2f ptDiff = m_vecRegions[r].ptCenter - ptPredicted;
+        const float fDistance = std::sqrt(ptDiff.x * ptDiff.x + ptDiff.y * ptDiff.y);
+        if (fDistance <= fGate)
+        {
+          m_vecCandidates.push_back(Candidate(fDistance, int(t), int(r)));
+        }
+      }
+    }
+
+    std::sort(m_vecCandidates.begin(), m_vecCandidates.end(),
+      [](const Candidate& a, const Candidate& b) { return a.fDistance < b.fDistance; });
+
+    for (const Candidate& candidate : m_vecCandidates)
+    {
+      if (m_vecTrackMatch[candidate.nTrack] >= 0 || m_vecRegionMatched[candidate.nRegion]) continue;
+      m_vecTrackMatch[candidate.nTrack] = candidate.nRegion;
+      m_vecRegionMatched[candidate.nRegion] = true;
+    }
+  }
+
+  // constant velocity prediction from the last two trajectory points,
+  // the velocity is per input frame (the points may be several frames apart)
+  static cv::Point2f predict(const HotTrack& track, uint64_t nFrame)
+  {
+    const std::deque<HotTrackPoint>& deqTrajectory = track.deqTrajectory;
+    if (deqTrajectory.size() < 2) return track.region.ptCenter;
+
+    const HotTrackPoint& last = deqTrajectory[deqTrajectory.size() - 1];
+    const HotTrackPoint& prev = deqTrajectory[deqTrajectory.size() - 2];
+    const cv::Point2f ptVelocity = (last.ptCenter - prev.ptCenter) * (1.0f / float(last.nFrame - prev.nFrame));
+    return last.ptCenter + ptVelocity * float(nFrame - last.nFrame);
+  }
+
+  void updateTrack(HotTrack& track, const HotRegion& region, double dTimestamp)
+  {
+    track.region = region;
+    track.nHits++;
+    track.nMissed = 0;
+    track.fMaxValue = std::max(track.fMaxValue, region.fMaxValue);
+    track.fMinValue = std::min(track.fMinValue, region.fMinValue);
+
+    HotTrackPoint point;
+    point.nFrame = m_nFrame;
+    point.dTimestamp = dTimestamp;
+    point.ptCenter = region.ptCenter;
+    point.fMaxValue = region.fMaxValue;
+    point.fMeanValue = region.fMeanValue;
+    track.deqTrajectory.push_back(point);
+    while (int(track.deqTrajectory.size()) > m_nTrajectoryLength)
+    {
+      track.deqTrajectory.pop_front();
+    }
+  }
+
+  struct Candidate
+  {
+    Candidate(float fDistanceInit, int nTrackInit, int nRegionInit)
+      : fDistance(fDistanceInit), nTrack(nTrackInit), nRegion(nRegionInit)
+    {
+    }
+
+    float fDistance;
+    int nTrack;
+    int nRegion;
+  };
+
+  float m_fThreshold;
+  double m_dBudgetMs;
+  int m_nMaxRegions;
+  int m_nRegionLimit;
+  int m_nMaxMissed;
+  int m_nTrajectoryLength;
+  float m_fGateDistance;
+  int m_nNextId;
+  double m_dLastMs;
+  double m_dLabelMs;
+  double m_dMatchMs;
+  int m_nFrameInterval;
+  int m_nSkippedFrames;
+
+  // number of the current input frame
+  uint64_t m_nFrame;
+
+  HotRegionLabeling m_labeling;
+  std::vector<HotRegion> m_vecRegions;
+  std::vector<HotTrack> m_vecTracks;
+
+  // matching buffers (reused per frame)
+  std::vector<int> m_vecTrackMatch;
+  std::vector<bool> m_vecRegionMatched;
+  std::vector<Candidate> m_vecCandidates;
+};
+
+#endif
@@ -0,0 +1,204 @@
+/***************************************************************************
+* Copyright: Testo SE & Co. KGaA, Testo-Straße 1, 79849 Lenzkirch
+***************************************************************************/
+/**@file
+@brief<b>Description: </b> read only memory mapped file (posix and windows)
+
+***************************************************************************/
+
+#ifndef IR_API_EXAMPLE_MAPPED_FILE_H
+#define IR_API_EXAMPLE_MAPPED_FILE_H
+
+/***************************************************************************
+* Includes
+***************************************************************************/
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+**************************************************************************
+@brief Read only mapping of a whole file
+
+open() returns false if the file can not be mapped (e.g. a file larger
+than the address space of a 32 bit process), the caller should fall back
+to stream reading then.
+
+The access hints are only implemented for posix (madvise), on windows
+they are ignored.
+**************************************************************************/
+class MappedFile
+{
+public:
+  enum AccessHint
+  {
+    AccessNormal,
+    AccessSequential,
+    AccessRandom
+  };
+
+  MappedFile()
+    : m_pData(nullptr)
+    , m_nSize(0)
+#ifdef _WIN32
+    , m_hFile(INVALID_HANDLE_VALUE)
+    , m_hMapping(nullptr)
+#endif
+  {
+  }
+
+  ~MappedFile()
+  {
+    close();
+  }
+
+  MappedFile(const MappedFile& other) = delete;
+  MappedFile& operator= (const MappedFile& rhs) = delete;
+
+  /**
+  *************************************************************************
+  map a file
+
+  @param [in] strPath file
+  @return true if the file is mapped
+  ************************************************************************/
+  bool open(const std::string& strPath)
+  {
+    close();
+
+#ifdef _WIN32
+    m_hFile = CreateFileA(strPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                          OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_hFile == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER nFileSize;
+    if (!GetFileSizeEx(m_hFile, &nFileSize) || nFileSize.QuadPart == 0 ||
+        uint64_t(nFileSize.QuadPart) > uint64_t(SIZE_MAX))
+    {
+      close();
+      return false;
+    }
+
+    m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_hMapping)
+    {
+      close();
+      return false;
+    }
+
+    void* pData = MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (!pData)
+    {
+      close();
+      return false;
+    }
+    m_pData = static_cast<const unsigned char*>(pData);
+    m_nSize = size_t(nFileSize.QuadPart);
+#else
+    const int nFile = ::open(strPath.c_str(), O_RDONLY);
+    if (nFile < 0) return false;
+
+    struct stat fileStat;
+    if (fstat(nFile, &fileStat) != 0 || fileStat.st_size == 0 ||
+        uint64_t(fileStat.st_size) > uint64_t(SIZE_MAX))
+    {
+      ::close(nFile);
+      return false;
+    }
+
+    void* pData = mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_SHARED, nFile, 0);
+    // the mapping stays valid without the descriptor
+    ::close(nFile);
+    if (pData == MAP_FAILED) return false;
+
+    m_pData = static_cast<const unsigned char*>(pData);
+    m_nSize = size_t(fileStat.st_size);
+#endif
+    return true;
+  }
+
+  void close()
+  {
+#ifdef _WIN32
+    if (m_pData) UnmapViewOfFile(m_pData);
+    if (m_hMapping) CloseHandle(m_hMapping);
+    if (m_hFile != INVALID_HANDLE_VALUE) CloseHandle(m_hFile);
+    m_hMapping = nullptr;
+    m_hFile = INVALID_HANDLE_VALUE;
+#else
+    if (m_pData) munmap(const_cast<unsigned char*>(m_pData), m_nSize);
+#endif
+    m_pData = nullptr;
+    m_nSize = 0;
+  }
+
+  bool isOpen() const { return m_pData != nullptr; }
+
+  const unsigned char* data() const { return m_pData; }
+
+  size_t size() const { return m_nSize; }
+
+  /**
+  *************************************************************************
+  set the expected access pattern of the whole file
+  ************************************************************************/
+  void setAccessHint(AccessHint hint)
+  {
+#ifndef _WIN32
+    if (!m_pData) return;
+    int nAdvice = MADV_NORMAL;
+    if (hint == AccessSequential) nAdvice = MADV_SEQUENTIAL;
+    else if (hint == AccessRandom) nAdvice = MADV_RANDOM;
+    madvise(const_cast<unsigned char*>(m_pData), m_nSize, nAdvice);
+#else
+    (void)hint;
+#endif
+  }
+
+  /**
+  *************************************************************************
+  start reading a range of the file in the background (read ahead)
+  ************************************************************************/
+  void prefetch(uint64_t nOffset, uint64_t nSize)
+  {
+#ifndef _WIN32
+    if (!m_pData || nOffset >= m_nSize) return;
+
+    // madvise needs a page aligned address
+    const uint64_t nPageSize = uint64_t(sysconf(_SC_PAGESIZE));
+    const uint64_t nStart = nOffset / nPageSize * nPageSize;
+    const uint64_t nEnd = (nOffset + nSize < m_nSize) ? nOffset + nSize : m_nSize;
+    madvise(const_cast<unsigned char*>(m_pData) + nStart, size_t(nEnd - nStart), MADV_WILLNEED);
+#else
+    (void)nOffset;
+    (void)nSize;
+#endif
+  }
+
+private:
+  const unsigned char* m_pData;
+  size_t m_nSize;
+
+#ifdef _WIN32
+  HANDLE m_hFile;
+  HANDLE m_hMapping;
+#endif
+};
+
+#endif
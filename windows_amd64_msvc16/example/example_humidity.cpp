@@ -0,0 +1,215 @@
+#include <irapi/Image.h>
+
+#include <string>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+
+#include <opencv2/core/hal/hal.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+// Magnus formula coefficients for saturation vapour pressure over water
+// es(T) = 6.112 hPa * exp(17.62 * T / (243.12 + T))
+const float fMagnusA = 17.62f;
+const float fMagnusB = 243.12f;
+
+// number of pixels processed per block (intermediate values stay in L1 cache)
+const int nBlockSize = 256;
+
+/**
+*************************************************************************
+Fused surface moisture kernel
+
+Converts a temperature image into surface moisture (%rH) and the palette
+color in one pass. The surface moisture is the relative humidity the air
+would have if it was cooled down to the surface temperature:
+
+  rH(Ts) = rH(Ta) * es(Ta) / es(Ts)
+         = rH(Ta) * exp(a * Ta / (b + Ta) - a * Ts / (b + Ts))
+
+All values are plain floats, the image is split into row stripes that are
+processed in parallel and each stripe is handled in small blocks.
+
+@param [in] matTemperature temperature image in degree Celsius
+@param [in] fHumidity reference humidity in %rH at ambient temperature
+@param [in] fAmbientTemperature ambient temperature in degree Celsius
+@param [in] matLutBgr palette (BGR, continuous) linear scaled from
+           fScaleBottom to fScaleTop
+@param [in] fScaleBottom surface moisture of the first palette color in %rH
+@param [in] fScaleTop surface moisture of the last palette color in %rH
+@param [out] matHumidity surface moisture image in %rH
+@param [out] matBgr palletized image
+************************************************************************/
+void calcSurfaceMoisture(const cv::Mat_<float>& matTemperature, float fHumidity,
+                         float fAmbientTemperature, const cv::Mat3b& matLutBgr,
+                         float fScaleBottom, float fScaleTop,
+                         cv::Mat_<float>& matHumidity, cv::Mat3b& matBgr)
+{
+  matHumidity.create(matTemperature.size());
+  matBgr.create(matTemperature.size());
+
+  const float fAmbientTerm = fMagnusA * fAmbientTemperature / (fMagnusB + fAmbientTemperature);
+  const int nMaxIndex = int(matLutBgr.total()) - 1;
+  const float fLutScale = (fScaleTop > fScaleBottom) ? nMaxIndex / (fScaleTop - fScaleBottom) : 0.0f;
+  const cv::Vec3b* pLut = matLutBgr.ptr<cv::Vec3b>();
+
+  cv::parallel_for_(cv::Range(0, matTemperature.rows), [&](const cv::Range& range)
+  {
+    float afExponent[nBlockSize];
+    int anIndex[nBlockSize];
+
+    for (int y = range.start; y < range.end; y++)
+    {
+      const float* pTemperature = matTemperature[y];
+      float* pHumidity = matHumidity[y];
+      cv::Vec3b* pBgr = matBgr[y];
+
+      for (int nStart = 0; nStart < matTemperature.cols; nStart += nBlockSize)
+      {
+        const int nCount = std::min(nBlockSize, matTemperature.cols - nStart);
+        const float* pSrc = pTemperature + nStart;
+        float* pDst = pHumidity + nStart;
+        int x = 0;
+
+        // exponent of the saturation vapour pressure ratio
+#if CV_SIMD
+        const cv::v_float32 vA = cv::vx_setall_f32(fMagnusA);
+        const cv::v_float32 vB = cv::vx_setall_f32(fMagnusB);
+        const cv::v_float32 vAmbient = cv::vx_setall_f32(fAmbientTerm);
+        for (; x <= nCount - cv::v_float32::nlanes; x += cv::v_float32::nlanes)
+        {
+          cv::v_float32 vT = cv::vx_load(pSrc + x);
+          cv::v_store(afExponent + x, vAmbient - vA * vT / (vB + vT));
+        }
+#endif
+        for (; x < nCount; x++)
+        {
+          afExponent[x] = fAmbientTerm - fMagnusA * pSrc[x] / (fMagnusB + pSrc[x]);
+        }
+
+        cv::hal::exp32f(afExponent, pDst, nCount);
+
+        // scale by reference humidity, clip to 0...100%rH and calculate palette index
+        x = 0;
+#if CV_SIMD
+        const cv::v_float32 vHumidity = cv::vx_setall_f32(fHumidity);
+        const cv::v_float32 vZero = cv::vx_setzero_f32();
+        const cv::v_float32 vMax = cv::vx_setall_f32(100.0f);
+        const cv::v_float32 vBottom = cv::vx_setall_f32(fScaleBottom);
+        const cv::v_float32 vLutScale = cv::vx_setall_f32(fLutScale);
+        const cv::v_int32 vMinIndex = cv::vx_setzero_s32();
+        const cv::v_int32 vMaxIndex = cv::vx_setall_s32(nMaxIndex);
+        for (; x <= nCount - cv::v_float32::nlanes; x += cv::v_float32::nlanes)
+        {
+          cv::v_float32 vRh = cv::v_min(cv::v_max(cv::vx_load(pDst + x) * vHumidity, vZero), vMax);
+          cv::v_store(pDst + x, vRh);
+          cv::v_int32 vIndex = cv::v_round((vRh - vBottom) * vLutScale);
+          cv::v_store(anIndex + x, cv::v_min(cv::v_max(vIndex, vMinIndex), vMaxIndex));
+        }
+#endif
+        for (; x < nCount; x++)
+        {
+          float fRh = std::min(std::max(pDst[x] * fHumidity, 0.0f), 100.0f);
+          pDst[x] = fRh;
+          anIndex[x] = std::min(std::max(cvRound((fRh - fScaleBottom) * fLutScale), 0), nMaxIndex);
+        }
+
+        for (x = 0; x < nCount; x++)
+        {
+          pBgr[nStart + x] = pLut[anIndex[x]];
+        }
+      }
+    }
+  });
+}
+
+bool existsFile(const std::string& strFilename)
+{
+  std::ifstream ifs(strFilename, std::ifstream::in);
+  return ifs.is_open();
+}
+
+int main(int argc, char* argv[])
+{
+  // This program compares the humidity mode of irapi::Image with a fused
+  // client side kernel that only needs the temperature image once
+
+  std::string strBmtFile = (argc > 1) ? argv[1] : "IR_EXAMPLE.BMT";
+  if (!existsFile(strBmtFile))
+  {
+    std::cout << "Could not open BMT file: " << strBmtFile << std::endl;
+    std::cout << "Please provide a bmt file as call parameter.\n";
+    return -1;
+  }
+
+  const int nIterations = 20;
+  const float fHumidityStart = 40.0f;
+  const float fHumidityStep = 1.0f;
+
+  irapi::Image image(strBmtFile);
+
+  // temperatures are read once in standard mode
+  image.setHumidityModeActive(false);
+  cv::Mat_<float> matTemperature(image.getIrImageData());
+
+  image.setHumidityModeActive(true);
+  const float fAmbientTemperature = image.getAmbientTemperature();
+
+  // humidity mode palette between scale bottom and top, getPaletteColors returns RGB
+  cv::Mat3b matLutBgr;
+  cv::cvtColor(image.getPaletteColors(256), matLutBgr, cv::COLOR_RGB2BGR);
+  const float fScaleBottom = image.getScaleBottom();
+  const float fScaleTop = image.getScaleTop();
+
+  std::cout << "image size          : " << matTemperature.cols << "x" << matTemperature.rows << std::endl;
+  std::cout << "ambient temperature : " << fAmbientTemperature << " Grad Celsius" << std::endl;
+  std::cout << "scale               : " << fScaleBottom << " ... " << fScaleTop << " %rH" << std::endl;
+
+  // current path: recalculation inside irapi::Image
+  cv::Mat_<float> matHumidityApi;
+  cv::Mat3b matBgrApi;
+  int64 nTicks = cv::getTickCount();
+  for (int i = 0; i < nIterations; i++)
+  {
+    image.setHumidity(fHumidityStart + i * fHumidityStep);
+    matHumidityApi = image.getIrImageData();
+    matBgrApi = image.getIrImageBgr();
+  }
+  double dApiMs = (cv::getTickCount() - nTicks) * 1000.0 / cv::getTickFrequency() / nIterations;
+
+  // fused kernel
+  cv::Mat_<float> matHumidity;
+  cv::Mat3b matBgr;
+  nTicks = cv::getTickCount();
+  for (int i = 0; i < nIterations; i++)
+  {
+    calcSurfaceMoisture(matTemperature, fHumidityStart + i * fHumidityStep, fAmbientTemperature,
+                        matLutBgr, fScaleBottom, fScaleTop, matHumidity, matBgr);
+  }
+  double dFusedMs = (cv::getTickCount() - nTicks) * 1000.0 / cv::getTickFrequency() / nIterations;
+
+  std::cout << "irapi::Image        : " << dApiMs << " ms per humidity change" << std::endl;
+  std::cout << "fused kernel        : " << dFusedMs << " ms per humidity change" << std::endl;
+
+  // both results are calculated with the last reference humidity
+  if (matHumidityApi.size() == matHumidity.size())
+  {
+    std::cout << "max deviation       : " << cv::norm(matHumidityApi, matHumidity, cv::NORM_INF) << " %rH" << std::endl;
+  }
+  if (matBgrApi.size() == matBgr.size())
+  {
+    // neighbouring palette colors differ by a few levels, rounding at the
+    // color boundaries is no error
+    cv::Mat matDiff;
+    cv::absdiff(matBgrApi, matBgr, matDiff);
+    matDiff = matDiff.reshape(1, int(matDiff.total()));
+    cv::reduce(matDiff, matDiff, 1, cv::REDUCE_MAX);
+    const int nDeviating = cv::countNonZero(matDiff > 8);
+    std::cout << "color deviation     : " << cv::norm(matDiff, cv::NORM_INF) << " max, "
+      << 100.0 * nDeviating / double(matDiff.total()) << " % of the pixels > 8" << std::endl;
+  }
+
+  std::cout << "\nPress ENTER to exit!\n>";
+  std::cin.ignore();
+}
@@ -0,0 +1,426 @@
+/***************************************************************************
+* Copyright: Testo SE & Co. KGaA, Testo-Straße 1, 79849 Lenzkirch
+***************************************************************************/
+/**@file
+@brief<b>Description: </b> run length based labeling of hot regions in ir frames
+
+***************************************************************************/
+
+#ifndef IR_API_EXAMPLE_HOT_REGION_LABELING_H
+#define IR_API_EXAMPLE_HOT_REGION_LABELING_H
+
+/***************************************************************************
+* Includes
+***************************************************************************/
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <opencv2/core/core.hpp>
+
+/**
+**************************************************************************
+@brief Hot region (connected pixels above a temperature threshold)
+**************************************************************************/
+struct HotRegion
+{
+  int nArea;
+  cv::Rect rectBoundingBox;
+
+  // center of gravity
+  cv::Point2f ptCenter;
+
+  // principal axes: variance along the major/minor axis and the angle of
+  // the major axis in radian
+  float fMajorVariance;
+  float fMinorVariance;
+  float fAngle;
+
+  float fMinValue;
+  float fMaxValue;
+  float fMeanValue;
+  cv::Point ptMax;
+
+  /**
+  *************************************************************************
+  @return ratio of major and minor axis (1 for round regions)
+  ************************************************************************/
+  float getElongation() const
+  {
+    if (fMinorVariance <= 0.0f) return (fMajorVariance > 0.0f) ? std::numeric_limits<float>::max() : 1.0f;
+    return std::sqrt(fMajorVariance / fMinorVariance);
+  }
+};
+
+/**
+**************************************************************************
+@brief Connected component labeling on runs (8 connectivity)
+
+The frame is split into row stripes that are labeled in parallel:
+every row is converted into runs of pixels above the threshold, runs
+touching a run of the previous row are joined with union find. A merge
+step joins the runs of neighbouring stripe borders. Area, bounding box,
+moments and temperature statistics are accumulated per run, so each pixel
+is read only once.
+
+All data is kept in flat arrays that are reused for the next frame.
+**************************************************************************/
+class HotRegionLabeling
+{
+public:
+  HotRegionLabeling()
+    : m_nMinArea(1)
+  {
+  }
+
+  /**
+  *************************************************************************
+  ignore regions with less pixels than nMinArea
+  ************************************************************************/
+  void setMinArea(int nMinArea)
+  {
+    m_nMinArea = std::max(nMinArea, 1);
+  }
+
+  /**
+  *************************************************************************
+  find hot regions
+
+  @param [in] matData temperature data
+  @param [in] fThreshold pixels with a value >= fThreshold are hot
+  @param [out] vecRegions found regions (sorted by area, largest first)
+  @param [out] pLabels optional label image (0 = background, region i has label i + 1)
+  ************************************************************************/
+  void label(const cv::Mat_<float>& matData, float fThreshold, std::vector<HotRegion>& vecRegions,
+             cv::Mat_<int>* pLabels = nullptr)
+  {
+    vecRegions.clear();
+    if (matData.empty()) return;
+
+    const int nStripes = std::max(1, std::min(cv::getNumThreads(), matData.rows / 16));
+    m_vecStripes.resize(nStripes);
+
+    cv::parallel_for_(cv::Range(0, nStripes), [&](const cv::Range& range)
+    {
+      for (int i = range.start; i < range.end; i++)
+      {
+        labelStripe(matData, fThreshold, matData.rows * i / nStripes,
+                    matData.rows * (i + 1) / nStripes, m_vecStripes[i]);
+      }
+    });
+
+    // concatenate stripes
+    m_vecRuns.clear();
+    m_vecParent.clear();
+    for (const Stripe& stripe : m_vecStripes)
+    {
+      const int nOffset = int(m_vecRuns.size());
+      m_vecRuns.insert(m_vecRuns.end(), stripe.vecRuns.begin(), stripe.vecRuns.end());
+      for (int nParent : stripe.vecParent)
+      {
+        m_vecParent.push_back(nParent + nOffset);
+      }
+    }
+
+    // merge step: join runs across stripe borders
+    int nOffset = 0;
+    for (int i = 0; i + 1 < nStripes; i++)
+    {
+      const Stripe& stripe = m_vecStripes[i];
+      const int nNextOffset = nOffset + int(stripe.vecRuns.size());
+      const Stripe& next = m_vecStripes[i + 1];
+      joinRows(stripe.nLastRowBegin, int(stripe.vecRuns.size()), nOffset,
+               next.vecRuns, 0, next.nFirstRowEnd, nNextOffset);
+      nOffset = nNextOffset;
+    }
+
+    // assign compact region indices and accumulate statistics
+    const int nRuns = int(m_vecRuns.size());
+    m_vecRegionIndex.assign(nRuns, -1);
+    m_vecMoments.clear();
+    for (int i = 0; i < nRuns; i++)
+    {
+      const int nRoot = find(i);
+      if (m_vecRegionIndex[nRoot] < 0)
+      {
+        m_vecRegionIndex[nRoot] = int(m_vecMoments.size());
+        m_vecMoments.push_back(Moments());
+      }
+      m_vecRegionIndex[i] = m_vecRegionIndex[nRoot];
+      m_vecMoments[m_vecRegionIndex[i]].add(m_vecRuns[i]);
+    }
+
+    // regions sorted by area, largest first
+    m_vecOrder.clear();
+    for (int i = 0; i < int(m_vecMoments.size()); i++)
+    {
+      if (m_vecMoments[i].nArea >= m_nMinArea) m_vecOrder.push_back(i);
+    }
+    std::stable_sort(m_vecOrder.begin(), m_vecOrder.end(),
+      [this](int a, int b) { return m_vecMoments[a].nArea > m_vecMoments[b].nArea; });
+
+    for (int nIndex : m_vecOrder)
+    {
+      vecRegions.push_back(m_vecMoments[nIndex].toRegion());
+    }
+
+    if (pLabels)
+    {
+      writeLabels(matData.size(), *pLabels);
+    }
+  }
+
+private:
+  struct Run
+  {
+    int nRow;
+    int nStart;
+    int nEnd; // inclusive
+
+    // temperature statistics of the run
+    float fSum;
+    float fMin;
+    float fMax;
+    int nMaxX;
+  };
+
+  struct Stripe
+  {
+    std::vector<Run> vecRuns;
+    std::vector<int> vecParent;
+    int nFirstRowEnd;   // runs [0, nFirstRowEnd) are in the first row of the stripe
+    int nLastRowBegin;  // runs [nLastRowBegin, size) are in the last row of the stripe
+  };
+
+  struct Moments
+  {
+    Moments()
+      : nArea(0), dSumX(0.0), dSumY(0.0), dSumXX(0.0), dSumYY(0.0), dSumXY(0.0), dSumValue(0.0)
+      , nMinX(std::numeric_limits<int>::max()), nMinY(std::numeric_limits<int>::max()), nMaxX(-1), nMaxY(-1)
+      , fMin(std::numeric_limits<float>::max()), fMax(-std::numeric_limits<float>::max())
+    {
+    }
+
+    void add(const Run& run)
+    {
+      const double n = run.nEnd - run.nStart + 1;
+      const double s = run.nStart;
+      const double e = run.nEnd;
+      const double y = run.nRow;
+      // sum of x and x^2 over [s, e]
+      const double dSx = n * (s + e) / 2.0;
+      const double dSxx = (e * (e + 1.0) * (2.0 * e + 1.0) - (s - 1.0) * s * (2.0 * s - 1.0)) / 6.0;
+
+      nArea += int(n);
+      dSumX += dSx;
+      dSumY += n * y;
+      dSumXX += dSxx;
+      dSumYY += n * y * y;
+      dSumXY += y * dSx;
+      dSumValue += run.fSum;
+
+      nMinX = std::min(nMinX, run.nStart);
+      nMaxX = std::max(nMaxX, run.nEnd);
+      nMinY = std::min(nMinY, run.nRow);
+      nMaxY = std::max(nMaxY, run.nRow);
+
+      fMin = std::min(fMin, run.fMin);
+      if (run.fMax > fMax)
+      {
+        fMax = run.fMax;
+        ptMax = cv::Point(run.nMaxX, run.nRow);
+      }
+    }
+
+    HotRegion toRegion() const
+    {
+      HotRegion region;
+      region.nArea = nArea;
+      region.rectBoundingBox = cv::Rect(nMinX, nMinY, nMaxX - nMinX + 1, nMaxY - nMinY + 1);
+
+      const double dCx = dSumX / nArea;
+      const double dCy = dSumY / nArea;
+      region.ptCenter = cv::Point2f(float(dCx), float(dCy));
+
+      // eigen values of the covariance matrix
+      const double dXX = dSumXX / nArea - dCx * dCx;
+      const double dYY = dSumYY / nArea - dCy * dCy;
+      const double dXY = dSumXY / nArea - dCx * dCy;
+      const double dMean = (dXX + dYY) / 2.0;
+      const double dDiff = std::sqrt(std::max((dXX - dYY) * (dXX - dYY) / 4.0 + dXY * dXY, 0.0));
+      region.fMajorVariance = float(dMean + dDiff);
+      region.fMinorVariance = float(std::max(dMean - dDiff, 0.0));
+      region.fAngle = float(0.5 * std::atan2(2.0 * dXY, dXX - dYY));
+
+      region.fMinValue = fMin;
+      region.fMaxValue = fMax;
+      region.fMeanValue = float(dSumValue / nArea);
+      region.ptMax = ptMax;
+      return region;
+    }
+
+    int nArea;
+    double dSumX, dSumY, dSumXX, dSumYY, dSumXY, dSumValue;
+    int nMinX, nMinY, nMaxX, nMaxY;
+    float fMin, fMax;
+    cv::Point ptMax;
+  };
+
+  static void labelStripe(const cv::Mat_<float>& matData, float fThreshold,
+                          int nRowBegin, int nRowEnd, Stripe& stripe)
+  {
+    stripe.vecRuns.clear();
+    stripe.vecParent.clear();
+    stripe.nFirstRowEnd = 0;
+    stripe.nLastRowBegin = 0;
+
+    int nPrevBegin = 0;
+    int nPrevEnd = 0;
+    for (int y = nRowBegin; y < nRowEnd; y++)
+    {
+      const float* pRow = matData[y];
+      const int nBegin = int(stripe.vecRuns.size());
+
+      int x = 0;
+      while (x < matData.cols)
+      {
+        while (x < matData.cols && !(pRow[x] >= fThreshold)) x++;
+        if (x == matData.cols) break;
+
+        Run run;
+        run.nRow = y;
+        run.nStart = x;
+        run.fSum = 0.0f;
+        run.fMin = pRow[x];
+        run.fMax = pRow[x];
+        run.nMaxX = x;
+        for (; x < matData.cols && pRow[x] >= fThreshold; x++)
+        {
+          run.fSum += pRow[x];
+          run.fMin = std::min(run.fMin, pRow[x]);
+          if (pRow[x] > run.fMax)
+          {
+            run.fMax = pRow[x];
+            run.nMaxX = x;
+          }
+        }
+        run.nEnd = x - 1;
+
+        stripe.vecParent.push_back(int(stripe.vecRuns.size()));
+        stripe.vecRuns.push_back(run);
+      }
+
+      const int nEnd = int(stripe.vecRuns.size());
+      if (y == nRowBegin)
+      {
+        stripe.nFirstRowEnd = nEnd;
+      }
+      else
+      {
+        joinRows(stripe.vecRuns, nPrevBegin, nPrevEnd, nBegin, nEnd, stripe.vecParent);
+      }
+      stripe.nLastRowBegin = nBegin;
+      nPrevBegin = nBegin;
+      nPrevEnd = nEnd;
+    }
+  }
+
+  // join touching runs of two neighbouring rows inside one stripe
+  static void joinRows(const std::vector<Run>& vecRuns, int nPrevBegin, int nPrevEnd,
+                       int nBegin, int nEnd, std::vector<int>& vecParent)
+  {
+    int i = nPrevBegin;
+    int j = nBegin;
+    while (i < nPrevEnd && j < nEnd)
+    {
+      const Run& prev = vecRuns[i];
+      const Run& cur = vecRuns[j];
+      if (prev.nEnd + 1 >= cur.nStart && cur.nEnd + 1 >= prev.nStart)
+      {
+        unite(vecParent, i, j);
+      }
+      // advance the run that ends first
+      if (prev.nEnd < cur.nEnd) i++;
+      else j++;
+    }
+  }
+
+  // join touching runs of the last row of a stripe and the first row of the next one
+  void joinRows(int nPrevBegin, int nPrevEnd, int nPrevOffset,
+                const std::vector<Run>& vecNext, int nBegin, int nEnd, int nNextOffset)
+  {
+    const std::vector<Run>& vecPrev = m_vecRuns;
+    int i = nPrevBegin;
+    int j = nBegin;
+    while (i < nPrevEnd && j < nEnd)
+    {
+      const Run& prev = vecPrev[nPrevOffset + i];
+      const Run& cur = vecNext[j];
+      if (prev.nRow + 1 == cur.nRow && prev.nEnd + 1 >= cur.nStart && cur.nEnd + 1 >= prev.nStart)
+      {
+        unite(m_vecParent, nPrevOffset + i, nNextOffset + j);
+      }
+      if (prev.nEnd < cur.nEnd) i++;
+      else j++;
+    }
+  }
+
+  static int find(std::vector<int>& vecParent, int i)
+  {
+    while (vecParent[i] != i)
+    {
+      vecParent[i] = vecParent[vecParent[i]];
+      i = vecParent[i];
+    }
+    return i;
+  }
+
+  int find(int i)
+  {
+    return find(m_vecParent, i);
+  }
+
+  static void unite(std::vector<int>& vecParent, int a, int b)
+  {
+    a = find(vecParent, a);
+    b = find(vecParent, b);
+    // the smaller index becomes the root to keep the region order stable
+    if (a < b) vecParent[b] = a;
+    else if (b < a) vecParent[a] = b;
+  }
+
+  void writeLabels(const cv::Size& size, cv::Mat_<int>& matLabels) const
+  {
+    matLabels.create(size);
+    matLabels.setTo(0);
+
+    // label of every compact region index (0 = filtered by minimal area)
+    std::vector<int> vecLabel(m_vecMoments.size(), 0);
+    for (size_t n = 0; n < m_vecOrder.size(); n++)
+    {
+      vecLabel[m_vecOrder[n]] = int(n) + 1;
+    }
+
+    for (size_t i = 0; i < m_vecRuns.size(); i++)
+    {
+      const Run& run = m_vecRuns[i];
+      const int nLabel = vecLabel[m_vecRegionIndex[i]];
+      if (nLabel == 0) continue;
+      int* pRow = matLabels[run.nRow];
+      std::fill(pRow + run.nStart, pRow + run.nEnd + 1, nLabel);
+    }
+  }
+
+  int m_nMinArea;
+
+  std::vector<Stripe> m_vecStripes;
+  std::vector<Run> m_vecRuns;
+  std::vector<int> m_vecParent;
+  std::vector<int> m_vecRegionIndex;
+  std::vector<Moments> m_vecMoments;
+  std::vector<int> m_vecOrder;
+};
+
+#endif
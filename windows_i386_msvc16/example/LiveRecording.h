@@ -0,0 +1,1346 @@
+/***************************************************************************
+* Copyright: Testo SE & Co. KGaA, Testo-Straße 1, 79849 Lenzkirch
+***************************************************************************/
+/**@file
+@brief<b>Description: </b> record and replay of live ir streams (multi frame PGM)
+
+***************************************************************************/
+
+#ifndef IR_API_EXAMPLE_LIVE_RECORDING_H
+#define IR_API_EXAMPLE_LIVE_RECORDING_H
+
+/***************************************************************************
+* Includes
+***************************************************************************/
+
+#include "RadiometricExport.h"
+#include "ThermalFrameCodec.h"
+#include "MappedFile.h"
+#include "SpscQueue.h"
+#include "FramePalette.h"
+
+#include <irapi/IrTypes.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <opencv2/core/core.hpp>
+
+/**
+**************************************************************************
+@brief Options of a live recording
+**************************************************************************/
+struct LiveRecordingOptions
+{
+  LiveRecordingOptions()
+    : nMaxCacheBytes(64 * 1024 * 1024)
+    , queuePolicy(QueueDropNewest)
+    , nThreads(2)
+    , bCompression(false)
+    , bPgmHeaders(false)
+  {
+  }
+
+  // frames waiting to be encoded
+  size_t nMaxCacheBytes;
+
+  // behaviour if the frames do not fit into the cache
+  QueueFullPolicy queuePolicy;
+
+  // threads that prepare (compress) the frame data
+  int nThreads;
+
+  // compress the frames with ThermalFrameCodec
+  bool bCompression;
+
+  // write text headers (netpbm compatible) instead of binary headers
+  bool bPgmHeaders;
+
+  // stored in the header of the first frame (e.g. getRadiometricMetaData)
+  RadiometricMetaData metaData;
+};
+
+/**
+**************************************************************************
+@brief One frame of a recording
+**************************************************************************/
+struct RecordedFrame
+{
+  uint64_t nFrame;
+
+  // seconds since the start of the recording
+  double dTimestamp;
+
+  float fScaleMin;
+  float fScaleMax;
+
+  RadiometricEncoding encoding;
+  cv::Mat_<unsigned short> matEncoded;
+
+  /**
+  *************************************************************************
+  @return temperatures in degree Celsius
+  ************************************************************************/
+  cv::Mat_<float> decode() const
+  {
+    cv::Mat_<float> matData;
+    matEncoded.convertTo(matData, CV_32F, 1.0 / encoding.fScale, -encoding.fOffset);
+    return matData;
+  }
+};
+
+/**
+**************************************************************************
+@brief Read only view of the encoded data of a recorded frame
+
+Points into the read only memory mapping of a recording, so only const
+rows are exposed; copyTo gives a writable image for OpenCV operations.
+**************************************************************************/
+class RecordedFrameView
+{
+public:
+  RecordedFrameView()
+    : m_pData(nullptr)
+    , m_size(0, 0)
+  {
+  }
+
+  RecordedFrameView(const unsigned short* pData, const cv::Size& size)
+    : m_pData(pData)
+    , m_size(size)
+  {
+  }
+
+  bool empty() const { return m_pData == nullptr; }
+
+  cv::Size size() const { return m_size; }
+
+  const unsigned short* ptr(int y) const { return m_pData + size_t(y) * size_t(m_size.width); }
+
+  unsigned short operator() (int y, int x) const { return ptr(y)[x]; }
+
+  /**
+  *************************************************************************
+  copy the data into a writable image
+  ************************************************************************/
+  void copyTo(cv::Mat_<unsigned short>& matDst) const
+  {
+    matDst.create(m_size);
+    for (int y = 0; y < m_size.height; y++)
+    {
+      std::memcpy(matDst[y], ptr(y), size_t(m_size.width) * sizeof(unsigned short));
+    }
+  }
+
+private:
+  const unsigned short* m_pData;
+  cv::Size m_size;
+};
+
+/**
+**************************************************************************
+@brief Index entry of a recorded frame
+**************************************************************************/
+struct RecordingIndexEntry
+{
+  uint64_t nDataOffset;
+  uint64_t nDataSize;
+  bool bCompressed;
+
+  // binary header frame: little endian data, the frame is padded to 8 bytes
+  bool bLittleEndian;
+  cv::Size size;
+  double dTimestamp;
+  float fScaleMin;
+  float fScaleMax;
+  RadiometricEncoding encoding;
+};
+
+/**
+**************************************************************************
+@return true if the frame data of the entry lies within a recording of
+        nFileSize bytes and has the size of the frame (uncompressed)
+**************************************************************************/
+inline bool isValidIndexEntry(const RecordingIndexEntry& entry, uint64_t nFileSize)
+{
+  if (entry.size.width <= 0 || entry.size.height <= 0) return false;
+  if (entry.nDataOffset > nFileSize || entry.nDataSize > nFileSize - entry.nDataOffset) return false;
+
+  const uint64_t nRawSize = uint64_t(entry.size.width) * uint64_t(entry.size.height) * sizeof(unsigned short);
+  return entry.bCompressed ? (entry.nDataSize > 0) : (entry.nDataSize == nRawSize);
+}
+
+/**
+**************************************************************************
+fingerprint of a recording for the sidecar index (FNV-1a of the
+modification time, the first and the last 4 KiB), detects an index left
+next to a new recording
+
+@param [in] strPath recording
+@param [in] nFileSize size of the recording
+**************************************************************************/
+inline uint64_t getRecordingFingerprint(const std::string& strPath, uint64_t nFileSize)
+{
+  const uint64_t nBlockSize = 4096;
+  uint64_t nHash = 14695981039346656037ull;
+
+#ifdef _WIN32
+  struct _stat64 fileStat;
+  const bool bStat = (_stat64(strPath.c_str(), &fileStat) == 0);
+#else
+  struct stat fileStat;
+  const bool bStat = (stat(strPath.c_str(), &fileStat) == 0);
+#endif
+  const int64_t nModified = bStat ? int64_t(fileStat.st_mtime) : 0;
+  for (int i = 0; i < 8; i++)
+  {
+    nHash = (nHash ^ uint64_t((nModified >> (8 * i)) & 0xFF)) * 1099511628211ull;
+  }
+
+  std::ifstream is(strPath, std::ios::binary);
+  char aBlock[4096];
+  const uint64_t aStart[2] = { 0, nFileSize > nBlockSize ? nFileSize - nBlockSize : 0 };
+  for (uint64_t nStart : aStart)
+  {
+    is.clear();
+    is.seekg(std::streamoff(nStart));
+    is.read(aBlock, std::streamsize(std::min(nBlockSize, nFileSize - nStart)));
+    for (std::streamsize i = 0; i < is.gcount(); i++)
+    {
+      nHash = (nHash ^ (unsigned char)aBlock[i]) * 1099511628211ull;
+    }
+  }
+  return nHash;
+}
+
+/**
+**************************************************************************
+write the sidecar index of a recording (<recording>.idx)
+
+Layout (little endian): "IRIDX002", uint64 recording file size,
+uint64 recording fingerprint, uint64 frame count, per frame 56 bytes:
+uint64 data offset, uint64 data size, uint32 compressed, int32 width,
+int32 height, float scale min, float scale max, float encoding offset,
+float encoding scale, uint32 flags (bit 0: little endian data),
+double timestamp.
+
+@return false if the index could not be written
+**************************************************************************/
+inline bool writeRecordingIndex(const std::string& strPath, uint64_t nFileSize, uint64_t nFingerprint,
+                                const std::vector<RecordingIndexEntry>& vecIndex)
+{
+  std::vector<unsigned char> vecData;
+  auto append = [&vecData](const void* pValue, size_t nSize)
+  {
+    const unsigned char* pBytes = static_cast<const unsigned char*>(pValue);
+    vecData.insert(vecData.end(), pBytes, pBytes + nSize);
+  };
+
+  const uint64_t nCount = vecIndex.size();
+  append("IRIDX002", 8);
+  append(&nFileSize, sizeof(nFileSize));
+  append(&nFingerprint, sizeof(nFingerprint));
+  append(&nCount, sizeof(nCount));
+  for (const RecordingIndexEntry& entry : vecIndex)
+  {
+    const uint32_t nCompressed = entry.bCompressed ? 1u : 0u;
+    const uint32_t nFlags = entry.bLittleEndian ? 1u : 0u;
+    const int32_t nWidth = entry.size.width;
+    const int32_t nHeight = entry.size.height;
+    append(&entry.nDataOffset, 8);
+    append(&entry.nDataSize, 8);
+    append(&nCompressed, 4);
+    append(&nWidth, 4);
+    append(&nHeight, 4);
+    append(&entry.fScaleMin, 4);
+    append(&entry.fScaleMax, 4);
+    append(&entry.encoding.fOffset, 4);
+    append(&entry.encoding.fScale, 4);
+    append(&nFlags, 4);
+    append(&entry.dTimestamp, 8);
+  }
+
+  std::ofstream ofs(strPath, std::ios::binary);
+  ofs.write(reinterpret_cast<const char*>(vecData.data()), std::streamsize(vecData.size()));
+  return ofs.good();
+}
+
+/**
+**************************************************************************
+read the sidecar index of a recording
+
+@return false if there is no valid index for the recording (size and
+        fingerprint have to match, older index versions are not read)
+**************************************************************************/
+inline bool readRecordingIndex(const std::string& strPath, uint64_t nFileSize, uint64_t nFingerprint,
+                               std::vector<RecordingIndexEntry>& vecIndex)
+{
+  std::ifstream ifs(strPath, std::ios::binary);
+  if (!ifs.is_open()) return false;
+
+  std::vector<unsigned char> vecData((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  const size_t nHeaderSize = 32;
+  const size_t nEntrySize = 56;
+  if (vecData.size() < nHeaderSize || std::memcmp(vecData.data(), "IRIDX002", 8) != 0) return false;
+
+  uint64_t nIndexFileSize = 0;
+  uint64_t nIndexFingerprint = 0;
+  uint64_t nCount = 0;
+  std::memcpy(&nIndexFileSize, &vecData[8], 8);
+  std::memcpy(&nIndexFingerprint, &vecData[16], 8);
+  std::memcpy(&nCount, &vecData[24], 8);
+  if (nIndexFileSize != nFileSize || nIndexFingerprint != nFingerprint ||
+      nCount > (vecData.size() - nHeaderSize) / nEntrySize ||
+      vecData.size() != nHeaderSize + nCount * nEntrySize)
+  {
+    return false;
+  }
+
+  vecIndex.resize(size_t(nCount));
+  const unsigned char* p = vecData.data() + nHeaderSize;
+  for (RecordingIndexEntry& entry : vecIndex)
+  {
+    uint32_t nCompressed = 0;
+    uint32_t nFlags = 0;
+    int32_t nWidth = 0;
+    int32_t nHeight = 0;
+    std::memcpy(&entry.nDataOffset, p, 8);
+    std::memcpy(&entry.nDataSize, p + 8, 8);
+    std::memcpy(&nCompressed, p + 16, 4);
+    std::memcpy(&nWidth, p + 20, 4);
+    std::memcpy(&nHeight, p + 24, 4);
+    std::memcpy(&entry.fScaleMin, p + 28, 4);
+    std::memcpy(&entry.fScaleMax, p + 32, 4);
+    std::memcpy(&entry.encoding.fOffset, p + 36, 4);
+    std::memcpy(&entry.encoding.fScale, p + 40, 4);
+    std::memcpy(&nFlags, p + 44, 4);
+    std::memcpy(&entry.dTimestamp, p + 48, 8);
+    entry.bCompressed = (nCompressed != 0);
+    entry.bLittleEndian = (nFlags & 1u) != 0;
+    entry.size = cv::Size(nWidth, nHeight);
+    p += nEntrySize;
+
+    if (!isValidIndexEntry(entry, nFileSize))
+    {
+      vecIndex.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+**************************************************************************
+@brief Live stream recorder
+
+Every frame starts with a binary header of fixed layout (little endian):
+
+  offset  type       content
+   0      char[4]    "IRFH"
+   4      uint16     header version (1)
+   6      uint16     header size (64, newer versions may append fields)
+   8      uint64     frame number
+  16      double     timestamp in seconds since the start of the recording
+  24      float      scale min
+  28      float      scale max
+  32      float      encoding offset
+  36      float      encoding scale
+  40      uint32     width
+  44      uint32     height
+  48      uint32     flags (bit 0: compressed)
+  52      uint32     size of the info block following the header
+  56      uint64     data size
+
+The info block (first frame only) holds "key=value" lines (see below),
+followed by the frame data (uint16 little endian or compressed). Every
+frame is padded to a multiple of 8 bytes, so uncompressed data is
+aligned and can be used in place (LiveReplay::getFrameView).
+
+With bPgmHeaders the recording is a sequence of binary PGM images
+(P5, 16 bit, big endian) as written by netpbm tools for multi image
+files. Every frame header carries its parameters as comments:
+
+  P5
+  # frame=12
+  # timestamp=2.671
+  # scale_min=18.5
+  # scale_max=31.2
+  # encoding_offset=273.15
+  # encoding_scale=100
+  160 120
+  65535
+
+The first frame additionally holds the color gradient of the live stream
+(gradient=hex BGR) and the options meta data (meta.<key>=<value>).
+
+Compressed PGM frames (bCompression) have the additional comments
+compression=rice and data_size=<bytes>, their data is the output of
+ThermalFrameCodec. Such files can only be read with LiveReplay. Frames
+that do not get smaller are stored uncompressed.
+
+LiveReplay reads both header formats.
+
+Frames are encoded (RadiometricEncoding) in addFrame. Byte swapping or
+compression runs in nThreads worker threads, a writer thread writes the
+frames in their order, so the caller is not blocked by the disk.
+
+The frames are handed round robin to the workers and from the workers to
+the writer through lock free queues (SpscQueue), one pair per worker;
+the writer merges them by frame number. The worker queues hold
+nMaxCacheBytes together, queuePolicy decides what happens to a frame
+that does not fit: QueueDropNewest drops it, QueueDropOldest drops the
+oldest frame of the worker (its frame number is missing in the
+recording), QueueBlock blocks addFrame until there is space.
+
+addFrame and close have to be called from the same thread.
+
+close() writes the frame index to <recording>.idx, so LiveReplay does
+not have to scan the recording.
+**************************************************************************/
+class LiveRecorder
+{
+public:
+  /**
+  **************************************************************************
+  Constructor, opens the file (throws std::runtime_error on failure)
+
+  @param [in] strPath recording file
+  @param [in] options recording options
+  ***************************************************************************/
+  LiveRecorder(const std::string& strPath, const LiveRecordingOptions& options = LiveRecordingOptions())
+    : m_options(options)
+    , m_strPath(strPath)
+    , m_ofs(strPath, std::ios::binary)
+    , m_nFileOffset(0)
+    , m_nFrames(0)
+    , m_nDroppedFrames(0)
+    , m_nCacheBytes(0)
+    , m_bClose(false)
+    , m_nRunningWorkers(0)
+    , m_nWrittenFrames(0)
+  {
+    if (!m_ofs.is_open())
+    {
+      throw std::runtime_error("LiveRecorder: could not open " + strPath);
+    }
+  }
+
+  ~LiveRecorder()
+  {
+    try
+    {
+      close();
+    }
+    catch (...)
+    {
+    }
+  }
+
+  LiveRecorder(const LiveRecorder& other) = delete;
+  LiveRecorder& operator= (const LiveRecorder& rhs) = delete;
+
+  /**
+  *************************************************************************
+  add a live frame
+
+  @param [in] frame live frame from captureLiveIr()
+  @return false if a frame was dropped (cache full or recorder closed)
+  ************************************************************************/
+  bool addFrame(const irapi::IrFrame& frame)
+  {
+    const auto now = std::chrono::steady_clock::now();
+
+    if (m_bClose)
+    {
+      m_nDroppedFrames++;
+      return false;
+    }
+
+    std::unique_ptr<Entry> pEntry(new Entry());
+    RecordedFrame& recordedFrame = pEntry->frame;
+    recordedFrame.fScaleMin = frame.fScaleMin;
+    recordedFrame.fScaleMax = frame.fScaleMax;
+    recordedFrame.encoding = RadiometricEncoding::forData(frame.matIrData);
+    recordedFrame.matEncoded.create(frame.matIrData.size());
+    for (int y = 0; y < frame.matIrData.rows; y++)
+    {
+      const float* pData = frame.matIrData[y];
+      unsigned short* pEncoded = recordedFrame.matEncoded[y];
+      for (int x = 0; x < frame.matIrData.cols; x++)
+      {
+        pEncoded[x] = recordedFrame.encoding.encode(pData[x]);
+      }
+    }
+
+    const size_t nBytes = recordedFrame.matEncoded.total() * sizeof(unsigned short);
+
+    if (m_vecWorkers.empty())
+    {
+      m_timeStart = now;
+      // continuous copy, the header stores it as one array
+      m_matGradient = frame.matScaleGradient.clone();
+      start(nBytes);
+    }
+
+    const uint64_t nFrame = m_nFrames;
+    recordedFrame.nFrame = nFrame;
+    recordedFrame.dTimestamp = std::chrono::duration<double>(now - m_timeStart).count();
+
+    m_nCacheBytes += nBytes;
+    Lane& lane = *m_vecLanes[size_t(nFrame % m_vecLanes.size())];
+    const bool bQueued = lane.input.push(pEntry, m_options.queuePolicy);
+    if (bQueued || m_options.queuePolicy == QueueDropOldest)
+    {
+      m_nFrames++;
+    }
+    if (!bQueued)
+    {
+      // pEntry is the dropped frame
+      m_nCacheBytes -= pEntry->frame.matEncoded.total() * sizeof(unsigned short);
+      m_nDroppedFrames++;
+    }
+    return bQueued;
+  }
+
+  /**
+  *************************************************************************
+  write all queued frames and close the file
+  (throws std::runtime_error if writing failed)
+  ************************************************************************/
+  void close()
+  {
+    if (m_bClose.exchange(true))
+    {
+      return;
+    }
+    for (auto& pLane : m_vecLanes)
+    {
+      pLane->input.wakeConsumer();
+    }
+    for (auto& worker : m_vecWorkers)
+    {
+      worker.join();
+    }
+    if (m_thread.joinable())
+    {
+      m_thread.join();
+    }
+
+    m_ofs.close();
+    if (m_strError.empty())
+    {
+      // without index the replay scans the recording
+      writeRecordingIndex(m_strPath + ".idx", m_nFileOffset, getRecordingFingerprint(m_strPath, m_nFileOffset), m_vecIndex);
+    }
+    else
+    {
+      throw std::runtime_error(m_strError);
+    }
+  }
+
+  /**
+  *************************************************************************
+  @return frames numbered so far, with QueueDropOldest this includes the
+          frames dropped from the queue later (see getWrittenFrames)
+  ************************************************************************/
+  uint64_t getFrames() const
+  {
+    return m_nFrames;
+  }
+
+  uint64_t getDroppedFrames() const
+  {
+    return m_nDroppedFrames;
+  }
+
+  /**
+  *************************************************************************
+  @return frames stored in the file, final after close()
+  ************************************************************************/
+  uint64_t getWrittenFrames() const
+  {
+    return m_nWrittenFrames;
+  }
+
+  /**
+  *************************************************************************
+  @return bytes of the frames waiting for the writer thread
+  ************************************************************************/
+  size_t getCacheBytes() const
+  {
+    return m_nCacheBytes;
+  }
+
+private:
+  struct Entry
+  {
+    Entry() : bCompressed(false) {}
+
+    RecordedFrame frame;
+
+    // frame data as written to the file (byte swapped or compressed)
+    std::vector<unsigned char> vecData;
+    bool bCompressed;
+  };
+
+  typedef std::unique_ptr<Entry> EntryPtr;
+
+  // queues of one worker; frame n is handled by worker n % workers
+  struct Lane
+  {
+    explicit Lane(size_t nCapacity) : input(nCapacity), output(nOutputCapacity) {}
+
+    SpscQueue<EntryPtr> input;
+    SpscQueue<EntryPtr> output;
+  };
+
+  // the queues are sized by the first frame
+  void start(size_t nFrameBytes)
+  {
+    const size_t nThreads = size_t(std::max(m_options.nThreads, 1));
+    const size_t nCapacity = std::max<size_t>(m_options.nMaxCacheBytes / std::max<size_t>(nFrameBytes, 1) / nThreads, 1);
+
+    for (size_t i = 0; i < nThreads; i++)
+    {
+      m_vecLanes.emplace_back(new Lane(nCapacity));
+    }
+    m_nRunningWorkers = int(nThreads);
+    for (size_t i = 0; i < nThreads; i++)
+    {
+      m_vecWorkers.emplace_back(&LiveRecorder::encodeLoop, this, std::ref(*m_vecLanes[i]));
+    }
+    m_thread = std::thread(&LiveRecorder::writeLoop, this);
+  }
+
+  // prepares the frame data of one lane
+  void encodeLoop(Lane& lane)
+  {
+    for (;;)
+    {
+      // close is set after the last frame was queued
+      const bool bClose = m_bClose;
+
+      EntryPtr pEntry;
+      if (!lane.input.tryPop(pEntry))
+      {
+        if (bClose) break;
+        lane.input.waitForData([this]() { return bool(m_bClose); });
+        continue;
+      }
+
+      encodeData(*pEntry);
+      lane.output.push(pEntry, QueueBlock);
+    }
+
+    // the writer may wait on any lane
+    m_nRunningWorkers--;
+    for (auto& pLane : m_vecLanes)
+    {
+      pLane->output.wakeConsumer();
+    }
+  }
+
+  // writes the prepared frames in order of their frame number
+  void writeLoop()
+  {
+    std::vector<EntryPtr> vecNext(m_vecLanes.size());
+    uint64_t nFrame = 0;
+    for (;;)
+    {
+      // the workers push their last frame before they stop
+      const bool bFinished = (m_nRunningWorkers == 0);
+
+      const size_t nLane = size_t(nFrame % m_vecLanes.size());
+      EntryPtr& pEntry = vecNext[nLane];
+      if (!pEntry && !m_vecLanes[nLane]->output.tryPop(pEntry))
+      {
+        if (!bFinished)
+        {
+          m_vecLanes[nLane]->output.waitForData([this]() { return m_nRunningWorkers == 0; });
+          continue;
+        }
+        if (nFrame >= m_nFrames) break;
+
+        // dropped frame at the end of the lane
+        nFrame++;
+        continue;
+      }
+
+      if (pEntry->frame.nFrame > nFrame)
+      {
+        // dropped frame (QueueDropOldest)
+        nFrame++;
+        continue;
+      }
+
+      if (m_strError.empty())
+      {
+        writeFrame(*pEntry);
+        if (m_strError.empty()) m_nWrittenFrames++;
+      }
+      m_nCacheBytes -= pEntry->frame.matEncoded.total() * sizeof(unsigned short);
+      pEntry.reset();
+      nFrame++;
+    }
+  }
+
+  void encodeData(Entry& entry) const
+  {
+    const cv::Mat_<unsigned short>& matEncoded = entry.frame.matEncoded;
+    const size_t nBytes = matEncoded.total() * sizeof(unsigned short);
+
+    if (m_options.bCompression)
+    {
+      ThermalFrameCodec::compress(matEncoded, entry.vecData);
+      entry.bCompressed = entry.vecData.size() < nBytes;
+      if (entry.bCompressed) return;
+    }
+
+    // pgm data is big endian, binary header frames are little endian
+    const int nHighByte = m_options.bPgmHeaders ? 0 : 1;
+    entry.vecData.resize(nBytes);
+    unsigned char* pData = entry.vecData.data();
+    for (int y = 0; y < matEncoded.rows; y++)
+    {
+      const unsigned short* pEncoded = matEncoded[y];
+      for (int x = 0; x < matEncoded.cols; x++, pData += 2)
+      {
+        pData[nHighByte] = (unsigned char)(pEncoded[x] >> 8);
+        pData[1 - nHighByte] = (unsigned char)(pEncoded[x] & 0xFF);
+      }
+    }
+  }
+
+  // "key=value" lines stored with the first frame
+  std::vector<std::string> getInfoLines() const
+  {
+    std::vector<std::string> vecLines;
+
+    std::ostringstream ossGradient;
+    ossGradient << "gradient=";
+    const cv::Mat3b& matGradient = m_matGradient;
+    for (size_t i = 0; i < matGradient.total(); i++)
+    {
+      const cv::Vec3b& color = matGradient.ptr<cv::Vec3b>()[i];
+      for (int c = 0; c < 3; c++)
+      {
+        ossGradient << std::hex << std::setw(2) << std::setfill('0') << int(color[c]);
+      }
+    }
+    vecLines.push_back(ossGradient.str());
+
+    for (const auto& item : m_options.metaData)
+    {
+      vecLines.push_back("meta." + item.first + "=" + item.second);
+    }
+    return vecLines;
+  }
+
+  std::string formatPgmHeader(const Entry& entry) const
+  {
+    const RecordedFrame& frame = entry.frame;
+
+    std::ostringstream ossHeader;
+    ossHeader << "P5\n";
+    ossHeader << "# frame=" << frame.nFrame << "\n";
+    ossHeader << "# timestamp=" << std::setprecision(17) << frame.dTimestamp << "\n";
+    ossHeader << std::setprecision(9);
+    ossHeader << "# scale_min=" << frame.fScaleMin << "\n";
+    ossHeader << "# scale_max=" << frame.fScaleMax << "\n";
+    ossHeader << "# encoding_offset=" << frame.encoding.fOffset << "\n";
+    ossHeader << "# encoding_scale=" << frame.encoding.fScale << "\n";
+    if (entry.bCompressed)
+    {
+      ossHeader << "# compression=rice\n";
+      ossHeader << "# data_size=" << entry.vecData.size() << "\n";
+    }
+
+    if (m_vecIndex.empty())
+    {
+      for (const std::string& strLine : getInfoLines())
+      {
+        ossHeader << "# " << strLine << "\n";
+      }
+    }
+
+    ossHeader << frame.matEncoded.cols << " " << frame.matEncoded.rows << "\n65535\n";
+    return ossHeader.str();
+  }
+
+  std::string formatBinaryHeader(const Entry& entry) const
+  {
+    const RecordedFrame& frame = entry.frame;
+
+    std::string strInfo;
+    if (m_vecIndex.empty())
+    {
+      for (const std::string& strLine : getInfoLines())
+      {
+        strInfo += strLine + "\n";
+      }
+      // keep the data aligned
+      strInfo.resize((strInfo.size() + 7) / 8 * 8, '\n');
+    }
+
+    const uint16_t nVersion = 1;
+    const uint16_t nHeaderSize = uint16_t(nBinaryHeaderSize);
+    const uint32_t nWidth = uint32_t(frame.matEncoded.cols);
+    const uint32_t nHeight = uint32_t(frame.matEncoded.rows);
+    const uint32_t nFlags = entry.bCompressed ? 1u : 0u;
+    const uint32_t nInfoSize = uint32_t(strInfo.size());
+    const uint64_t nDataSize = entry.vecData.size();
+
+    std::string strHeader(nBinaryHeaderSize, '\0');
+    char* p = &strHeader[0];
+    std::memcpy(p, "IRFH", 4);
+    std::memcpy(p + 4, &nVersion, 2);
+    std::memcpy(p + 6, &nHeaderSize, 2);
+    std::memcpy(p + 8, &frame.nFrame, 8);
+    std::memcpy(p + 16, &frame.dTimestamp, 8);
+    std::memcpy(p + 24, &frame.fScaleMin, 4);
+    std::memcpy(p + 28, &frame.fScaleMax, 4);
+    std::memcpy(p + 32, &frame.encoding.fOffset, 4);
+    std::memcpy(p + 36, &frame.encoding.fScale, 4);
+    std::memcpy(p + 40, &nWidth, 4);
+    std::memcpy(p + 44, &nHeight, 4);
+    std::memcpy(p + 48, &nFlags, 4);
+    std::memcpy(p + 52, &nInfoSize, 4);
+    std::memcpy(p + 56, &nDataSize, 8);
+    return strHeader + strInfo;
+  }
+
+  void writeFrame(const Entry& entry)
+  {
+    const RecordedFrame& frame = entry.frame;
+    const bool bBinary = !m_options.bPgmHeaders;
+
+    const std::string strHeader = bBinary ? formatBinaryHeader(entry) : formatPgmHeader(entry);
+    m_ofs.write(strHeader.data(), std::streamsize(strHeader.size()));
+    m_ofs.write(reinterpret_cast<const char*>(entry.vecData.data()), std::streamsize(entry.vecData.size()));
+
+    RecordingIndexEntry indexEntry;
+    indexEntry.nDataOffset = m_nFileOffset + strHeader.size();
+    indexEntry.nDataSize = entry.vecData.size();
+    indexEntry.bCompressed = entry.bCompressed;
+    indexEntry.bLittleEndian = bBinary;
+    indexEntry.size = frame.matEncoded.size();
+    indexEntry.dTimestamp = frame.dTimestamp;
+    indexEntry.fScaleMin = frame.fScaleMin;
+    indexEntry.fScaleMax = frame.fScaleMax;
+    indexEntry.encoding = frame.encoding;
+    m_vecIndex.push_back(indexEntry);
+    m_nFileOffset = indexEntry.nDataOffset + indexEntry.nDataSize;
+
+    if (bBinary && m_nFileOffset % 8 != 0)
+    {
+      const char aPadding[8] = {};
+      m_ofs.write(aPadding, std::streamsize(8 - m_nFileOffset % 8));
+      m_nFileOffset += 8 - m_nFileOffset % 8;
+    }
+
+    if (!m_ofs.good())
+    {
+      m_strError = "LiveRecorder: write failed";
+    }
+  }
+
+  static const size_t nBinaryHeaderSize = 64;
+
+  // encoded frames per worker waiting for the writer
+  static const size_t nOutputCapacity = 4;
+
+  LiveRecordingOptions m_options;
+  std::string m_strPath;
+  std::ofstream m_ofs;
+
+  // only used by the writer thread (and close after join)
+  uint64_t m_nFileOffset;
+  std::vector<RecordingIndexEntry> m_vecIndex;
+
+  // written by the thread of addFrame
+  std::atomic<uint64_t> m_nFrames;
+  std::atomic<uint64_t> m_nDroppedFrames;
+  std::atomic<size_t> m_nCacheBytes;
+  std::atomic<bool> m_bClose;
+  std::atomic<int> m_nRunningWorkers;
+  std::chrono::steady_clock::time_point m_timeStart;
+
+  // set before the first frame is queued
+  cv::Mat3b m_matGradient;
+
+  // only written by the writer thread, read after join
+  std::string m_strError;
+  std::atomic<uint64_t> m_nWrittenFrames;
+
+  std::vector<std::unique_ptr<Lane> > m_vecLanes;
+  std::vector<std::thread> m_vecWorkers;
+  std::thread m_thread;
+};
+
+/**
+**************************************************************************
+@brief Replay of a recording with the live interface of irapi::Cam
+
+The frame index is read from <recording>.idx if it matches the recording,
+otherwise it is built (only the frame headers are read, the data is
+skipped). With bWriteIndex a built index is stored as <recording>.idx for
+the next time; a failed write (e.g. read only media) is ignored.
+
+The frames are read from a memory mapping of the recording, the data is
+byte swapped or decompressed directly from the mapping into the frame
+(one copy). captureLiveIr() starts reading the next frames in the
+background (read ahead). If the file can not be mapped (e.g. a file
+larger than the address space of a 32 bit process) the frames are read
+with a stream.
+
+captureLiveIr() returns the
+frames with the recorded timing divided by the speed factor, speed 0
+returns the frames as fast as they are polled (offline processing).
+At the end of the recording isConnected() returns false and
+captureLiveIr() throws irapi::CameraNotConnectedException.
+**************************************************************************/
+class LiveReplay
+{
+public:
+  /**
+  **************************************************************************
+  Constructor, opens the file and builds the index
+  (throws std::runtime_error on failure or for a corrupt recording)
+
+  @param [in] strPath recording file
+  @param [in] dSpeed replay speed (1 = real time, 0 = unlimited)
+  @param [in] bWriteIndex store a built index next to the recording
+  ***************************************************************************/
+  LiveReplay(const std::string& strPath, double dSpeed = 1.0, bool bWriteIndex = false)
+    : m_ifs(strPath, std::ios::binary)
+    , m_nFileSize(0)
+    , m_dSpeed(std::max(dSpeed, 0.0))
+    , m_nReadAhead(4)
+    , m_nNext(0)
+    , m_bClockStarted(false)
+  {
+    if (!m_ifs.is_open())
+    {
+      throw std::runtime_error("LiveReplay: could not open " + strPath);
+    }
+
+    m_ifs.seekg(0, std::ios::end);
+    m_nFileSize = uint64_t(m_ifs.tellg());
+    m_ifs.seekg(0);
+
+    const uint64_t nFingerprint = getRecordingFingerprint(strPath, m_nFileSize);
+    try
+    {
+      if (readRecordingIndex(strPath + ".idx", m_nFileSize, nFingerprint, m_vecIndex))
+      {
+        // meta data and gradient are in the first frame header
+        RecordingIndexEntry entry;
+        parseHeader(m_nFileSize, entry);
+      }
+      else
+      {
+        buildIndex(m_nFileSize);
+        if (bWriteIndex)
+        {
+          writeRecordingIndex(strPath + ".idx", m_nFileSize, nFingerprint, m_vecIndex);
+        }
+      }
+    }
+    catch (const std::runtime_error& e)
+    {
+      throw std::runtime_error(std::string(e.what()) + " in " + strPath);
+    }
+    catch (const std::logic_error&)
+    {
+      // invalid number in a text header (std::stod, std::stoi, ...)
+      throw std::runtime_error("LiveReplay: invalid frame header in " + strPath);
+    }
+
+    if (m_file.open(strPath))
+    {
+      m_file.setAccessHint(MappedFile::AccessSequential);
+    }
+  }
+
+  /**
+  *************************************************************************
+  set the access pattern (sequential: read ahead, random: no read ahead)
+  ************************************************************************/
+  void setSequentialAccess(bool bSequential)
+  {
+    m_file.setAccessHint(bSequential ? MappedFile::AccessSequential : MappedFile::AccessRandom);
+    m_nReadAhead = bSequential ? 4 : 0;
+  }
+
+  size_t getFrameCount() const { return m_vecIndex.size(); }
+
+  const RadiometricMetaData& getMetaData() const { return m_metaData; }
+
+  const cv::Mat3b& getScaleGradient() const { return m_matGradient; }
+
+  void setSpeed(double dSpeed)
+  {
+    m_dSpeed = std::max(dSpeed, 0.0);
+    m_bClockStarted = false;
+  }
+
+  /**
+  *************************************************************************
+  @return recorded timestamp of a frame in seconds
+  ************************************************************************/
+  double getTimestamp(size_t nFrame) const { return m_vecIndex.at(nFrame).dTimestamp; }
+
+  /**
+  *************************************************************************
+  set the next frame returned by captureLiveIr()
+  ************************************************************************/
+  void seek(size_t nFrame)
+  {
+    m_nNext = std::min(nFrame, m_vecIndex.size());
+    m_bClockStarted = false;
+  }
+
+  /**
+  *************************************************************************
+  random access to a frame (throws std::out_of_range, std::runtime_error
+  for a corrupt recording)
+  ************************************************************************/
+  void readFrame(size_t nFrame, RecordedFrame& frame)
+  {
+    const IndexEntry& entry = m_vecIndex.at(nFrame);
+    if (!isValidIndexEntry(entry, m_nFileSize))
+    {
+      throw std::runtime_error("LiveReplay: invalid frame " + std::to_string(nFrame));
+    }
+
+    frame.nFrame = nFrame;
+    frame.dTimestamp = entry.dTimestamp;
+    frame.fScaleMin = entry.fScaleMin;
+    frame.fScaleMax = entry.fScaleMax;
+    frame.encoding = entry.encoding;
+    frame.matEncoded.create(entry.size);
+
+    const unsigned char* pData = nullptr;
+    if (m_file.isOpen() && entry.nDataOffset + entry.nDataSize <= m_file.size())
+    {
+      pData = m_file.data() + entry.nDataOffset;
+    }
+    else
+    {
+      m_vecBuffer.resize(size_t(entry.nDataSize));
+      m_ifs.clear();
+      m_ifs.seekg(std::streamoff(entry.nDataOffset));
+      m_ifs.read(reinterpret_cast<char*>(m_vecBuffer.data()), std::streamsize(m_vecBuffer.size()));
+      if (!m_ifs.good())
+      {
+        throw std::runtime_error("LiveReplay: could not read frame " + std::to_string(nFrame));
+      }
+      pData = m_vecBuffer.data();
+    }
+
+    if (entry.bCompressed)
+    {
+      ThermalFrameCodec::decompress(pData, size_t(entry.nDataSize), frame.matEncoded);
+      return;
+    }
+
+    // pgm data is big endian, binary header frames are little endian
+    const size_t nHighByte = entry.bLittleEndian ? 1 : 0;
+    unsigned short* pEncoded = frame.matEncoded.ptr<unsigned short>();
+    for (size_t i = 0; i < frame.matEncoded.total(); i++)
+    {
+      pEncoded[i] = (unsigned short)((pData[2 * i + nHighByte] << 8) | pData[2 * i + 1 - nHighByte]);
+    }
+  }
+
+  /**
+  *************************************************************************
+  view of the encoded data of a frame in the memory mapping (no copy)
+
+  Only possible for uncompressed frames with binary header of a mapped
+  recording. The view is valid as long as this object.
+
+  @return false if no view is possible (use readFrame)
+  ************************************************************************/
+  bool getFrameView(size_t nFrame, RecordedFrameView& view) const
+  {
+    const IndexEntry& entry = m_vecIndex.at(nFrame);
+    if (!m_file.isOpen() || entry.bCompressed || !entry.bLittleEndian || entry.nDataOffset % 2 != 0 ||
+        !isValidIndexEntry(entry, m_file.size()))
+    {
+      return false;
+    }
+
+    const unsigned char* pData = m_file.data() + entry.nDataOffset;
+    view = RecordedFrameView(reinterpret_cast<const unsigned short*>(pData), entry.size);
+    return true;
+  }
+
+  /**************************************************************************
+  * irapi::Cam live interface
+  ***************************************************************************/
+
+  bool isConnected() { return m_nNext < m_vecIndex.size(); }
+
+  bool waitUntilConnected(int) { return isConnected(); }
+
+  irapi::IrFrame captureLiveIr()
+  {
+    if (!isConnected())
+    {
+      throw irapi::CameraNotConnectedException("end of recording");
+    }
+
+    if (m_dSpeed > 0.0)
+    {
+      if (!m_bClockStarted)
+      {
+        m_bClockStarted = true;
+        m_timeStart = std::chrono::steady_clock::now();
+        m_dStartTimestamp = m_vecIndex[m_nNext].dTimestamp;
+      }
+      const double dDelay = (m_vecIndex[m_nNext].dTimestamp - m_dStartTimestamp) / m_dSpeed;
+      std::this_thread::sleep_until(m_timeStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(dDelay)));
+    }
+
+    if (m_nReadAhead > 0 && m_nNext + 1 < m_vecIndex.size())
+    {
+      const RecordingIndexEntry& first = m_vecIndex[m_nNext + 1];
+      const RecordingIndexEntry& last = m_vecIndex[std::min(m_nNext + m_nReadAhead, m_vecIndex.size() - 1)];
+      m_file.prefetch(first.nDataOffset, last.nDataOffset + last.nDataSize - first.nDataOffset);
+    }
+
+    readFrame(m_nNext++, m_frame);
+
+    irapi::IrFrame frame;
+    frame.matIrData = m_frame.decode();
+    frame.fScaleMin = m_frame.fScaleMin;
+    frame.fScaleMax = m_frame.fScaleMax;
+    frame.matScaleGradient = m_matGradient;
+    palletizeFrame(frame);
+    return frame;
+  }
+
+  void stopLiveIr()
+  {
+    m_bClockStarted = false;
+  }
+
+private:
+  typedef RecordingIndexEntry IndexEntry;
+
+  void buildIndex(uint64_t nFileSize)
+  {
+    IndexEntry entry;
+    while (parseHeader(nFileSize, entry))
+    {
+      m_vecIndex.push_back(entry);
+
+      // skip the data (and the padding of binary header frames)
+      uint64_t nNext = entry.nDataOffset + entry.nDataSize;
+      if (entry.bLittleEndian) nNext = (nNext + 7) / 8 * 8;
+      m_ifs.seekg(std::streamoff(nNext));
+    }
+  }
+
+  // reads the frame header at the current stream position
+  // returns false at the end of the file or for an incomplete frame
+  bool parseHeader(uint64_t nFileSize, IndexEntry& entry)
+  {
+    const int nFirst = m_ifs.peek();
+    if (nFirst == std::char_traits<char>::eof()) return false;
+    if (nFirst == 'I') return parseBinaryHeader(nFileSize, entry);
+
+    std::string strLine;
+    if (!std::getline(m_ifs, strLine)) return false;
+
+    if (strLine != "P5")
+    {
+      throw std::runtime_error("LiveReplay: invalid frame header");
+    }
+
+    entry.bLittleEndian = false;
+    entry.dTimestamp = 0.0;
+    entry.fScaleMin = 0.0f;
+    entry.fScaleMax = 0.0f;
+    entry.encoding.fOffset = 0.0f;
+    entry.encoding.fScale = 1.0f;
+    entry.nDataSize = 0;
+    entry.bCompressed = false;
+
+    while (std::getline(m_ifs, strLine) && !strLine.empty() && strLine[0] == '#')
+    {
+      const size_t nSeparator = strLine.find('=');
+      if (nSeparator == std::string::npos) continue;
+
+      const std::string strKey = strLine.substr(2, nSeparator - 2);
+      const std::string strValue = strLine.substr(nSeparator + 1);
+      if (strKey == "timestamp") entry.dTimestamp = std::stod(strValue);
+      else if (strKey == "scale_min") entry.fScaleMin = std::stof(strValue);
+      else if (strKey == "scale_max") entry.fScaleMax = std::stof(strValue);
+      else if (strKey == "encoding_offset") entry.encoding.fOffset = std::stof(strValue);
+      else if (strKey == "encoding_scale") entry.encoding.fScale = std::stof(strValue);
+      else if (strKey == "compression") entry.bCompressed = (strValue == "rice");
+      else if (strKey == "data_size") entry.nDataSize = std::stoull(strValue);
+      else parseInfo(strKey, strValue);
+    }
+
+    int nMaxValue = 0;
+    std::istringstream(strLine) >> entry.size.width >> entry.size.height;
+    m_ifs >> nMaxValue;
+    m_ifs.get();
+    if (!m_ifs.good())
+    {
+      return false;
+    }
+    if (entry.size.width <= 0 || entry.size.height <= 0 || entry.size.width > 65535 || entry.size.height > 65535 ||
+        nMaxValue != 65535)
+    {
+      throw std::runtime_error("LiveReplay: invalid frame header");
+    }
+
+    entry.nDataOffset = uint64_t(m_ifs.tellg());
+    if (!entry.bCompressed)
+    {
+      entry.nDataSize = uint64_t(entry.size.width) * uint64_t(entry.size.height) * sizeof(unsigned short);
+    }
+    if (entry.nDataOffset + entry.nDataSize > nFileSize)
+    {
+      // incomplete last frame (recording was not closed)
+      return false;
+    }
+    if (!isValidIndexEntry(entry, nFileSize))
+    {
+      throw std::runtime_error("LiveReplay: invalid frame header");
+    }
+    return true;
+  }
+
+  bool parseBinaryHeader(uint64_t nFileSize, IndexEntry& entry)
+  {
+    const uint64_t nStart = uint64_t(m_ifs.tellg());
+
+    char aHeader[64];
+    m_ifs.read(aHeader, sizeof(aHeader));
+    if (m_ifs.gcount() != std::streamsize(sizeof(aHeader))) return false;
+
+    uint16_t nVersion = 0;
+    uint16_t nHeaderSize = 0;
+    std::memcpy(&nVersion, aHeader + 4, 2);
+    std::memcpy(&nHeaderSize, aHeader + 6, 2);
+    if (std::memcmp(aHeader, "IRFH", 4) != 0 || nVersion == 0 || nHeaderSize < sizeof(aHeader))
+    {
+      throw std::runtime_error("LiveReplay: invalid frame header");
+    }
+
+    uint32_t nWidth = 0;
+    uint32_t nHeight = 0;
+    uint32_t nFlags = 0;
+    uint32_t nInfoSize = 0;
+    std::memcpy(&entry.dTimestamp, aHeader + 16, 8);
+    std::memcpy(&entry.fScaleMin, aHeader + 24, 4);
+    std::memcpy(&entry.fScaleMax, aHeader + 28, 4);
+    std::memcpy(&entry.encoding.fOffset, aHeader + 32, 4);
+    std::memcpy(&entry.encoding.fScale, aHeader + 36, 4);
+    std::memcpy(&nWidth, aHeader + 40, 4);
+    std::memcpy(&nHeight, aHeader + 44, 4);
+    std::memcpy(&nFlags, aHeader + 48, 4);
+    std::memcpy(&nInfoSize, aHeader + 52, 4);
+    std::memcpy(&entry.nDataSize, aHeader + 56, 8);
+    entry.size = cv::Size(int(nWidth), int(nHeight));
+    entry.bCompressed = (nFlags & 1u) != 0;
+    entry.bLittleEndian = true;
+
+    if (nWidth == 0 || nHeight == 0 || nWidth > 65535 || nHeight > 65535)
+    {
+      throw std::runtime_error("LiveReplay: invalid frame header");
+    }
+
+    // fields of newer header versions are skipped
+    entry.nDataOffset = nStart + nHeaderSize + nInfoSize;
+    if (entry.nDataOffset > nFileSize || entry.nDataSize > nFileSize - entry.nDataOffset)
+    {
+      // incomplete last frame (recording was not closed)
+      return false;
+    }
+    if (!isValidIndexEntry(entry, nFileSize))
+    {
+      throw std::runtime_error("LiveReplay: invalid frame header");
+    }
+
+    if (nInfoSize > 0)
+    {
+      m_ifs.seekg(std::streamoff(nStart + nHeaderSize));
+      std::string strInfo(nInfoSize, '\0');
+      m_ifs.read(&strInfo[0], std::streamsize(nInfoSize));
+
+      std::istringstream issInfo(strInfo);
+      std::string strLine;
+      while (std::getline(issInfo, strLine))
+      {
+        const size_t nSeparator = strLine.find('=');
+        if (nSeparator == std::string::npos) continue;
+        parseInfo(strLine.substr(0, nSeparator), strLine.substr(nSeparator + 1));
+      }
+    }
+
+    m_ifs.seekg(std::streamoff(entry.nDataOffset));
+    return true;
+  }
+
+  // recording information (first frame)
+  void parseInfo(const std::string& strKey, const std::string& strValue)
+  {
+    if (strKey == "gradient") m_matGradient = parseGradient(strValue);
+    else if (strKey.compare(0, 5, "meta.") == 0) m_metaData.push_back(std::make_pair(strKey.substr(5), strValue));
+  }
+
+  static cv::Mat3b parseGradient(const std::string& strHex)
+  {
+    cv::Mat3b matGradient(int(strHex.size() / 6), 1);
+    for (int i = 0; i < matGradient.rows; i++)
+    {
+      for (int c = 0; c < 3; c++)
+      {
+        matGradient(i, 0)[c] = (unsigned char)std::stoi(strHex.substr(size_t(i) * 6 + size_t(c) * 2, 2), nullptr, 16);
+      }
+    }
+    return matGradient;
+  }
+
+  std::ifstream m_ifs;
+  uint64_t m_nFileSize;
+  MappedFile m_file;
+  double m_dSpeed;
+  size_t m_nReadAhead;
+
+  std::vector<IndexEntry> m_vecIndex;
+  RadiometricMetaData m_metaData;
+  cv::Mat3b m_matGradient;
+
+  size_t m_nNext;
+  bool m_bClockStarted;
+  std::chrono::steady_clock::time_point m_timeStart;
+  double m_dStartTimestamp;
+
+  RecordedFrame m_frame;
+  std::vector<unsigned char> m_vecBuffer;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include <irapi/Image.h>
+
+#include "RadiometricExport.h"
+
+#include <string>
+#include <thread>
+#include <iostream>
+#include <fstream>
+
+bool existsFile(const std::string& strFilename)
+{
+  std::ifstream ifs(strFilename, std::ifstream::in);
+  return ifs.is_open();
+}
+
+int main(int argc, char* argv[])
+{
+  // This program exports the temperatures of a BMT file as radiometric
+  // TIFF (float32 and uint16) and 16 bit PNG
+  // call parameter: [bmt file] [output base name]
+
+  std::string strBmtFile = (argc > 1) ? argv[1] : "IR_EXAMPLE.BMT";
+  std::string strOutput = (argc > 2) ? argv[2] : "IR_EXAMPLE";
+  if (!existsFile(strBmtFile))
+  {
+    std::cout << "Could not open BMT file: " << strBmtFile << std::endl;
+    std::cout << "Please provide a bmt file as call parameter.\n";
+    return -1;
+  }
+
+  irapi::Image image(strBmtFile);
+  cv::Mat_<float> matData(image.getIrImageData());
+  const RadiometricMetaData metaData = getRadiometricMetaData(image);
+
+  std::cout << "image size : " << matData.cols << "x" << matData.rows << std::endl;
+
+  RadiometricTiffWriter writer;
+  writer.setThreads(int(std::max(1u, std::thread::hardware_concurrency())));
+
+  // float32 tiff, temperatures in degree Celsius
+  int64 nTicks = cv::getTickCount();
+  {
+    std::ofstream ofs(strOutput + "_float.tif", std::ios::binary);
+    writer.write(ofs, matData, metaData, false);
+  }
+  std::cout << "float32 tiff : "
+    << (cv::getTickCount() - nTicks) * 1000.0 / cv::getTickFrequency() << " ms" << std::endl;
+
+  // uint16 tiff, encoding is stored in the description
+  nTicks = cv::getTickCount();
+  {
+    std::ofstream ofs(strOutput + "_uint16.tif", std::ios::binary);
+    writer.write(ofs, matData, metaData, true);
+  }
+  std::cout << "uint16 tiff  : "
+    << (cv::getTickCount() - nTicks) * 1000.0 / cv::getTickFrequency() << " ms" << std::endl;
+
+  // 16 bit png, encoding and meta data as text chunks
+  nTicks = cv::getTickCount();
+  {
+    const std::vector<unsigned char> vecPng = encodeRadiometricPng(matData, metaData);
+    std::ofstream ofs(strOutput + "_uint16.png", std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(vecPng.data()), std::streamsize(vecPng.size()));
+  }
+  std::cout << "uint16 png   : "
+    << (cv::getTickCount() - nTicks) * 1000.0 / cv::getTickFrequency() << " ms" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,245 @@
+#include <irapi/Cam.h>
+
+#include "FramePalette.h"
+
+#include <string>
+#include <deque>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+/**
+**************************************************************************
+@brief Incremental multi frame super resolution for live ir frames
+
+Keeps a sliding window of the last live frames. Every new frame is
+registered against the previous one (phase correlation), the shifts of
+all frames in the window are kept relative to the newest frame.
+The high resolution estimate is warm started from the previous estimate
+and refined with a few iterative back projection steps over the window.
+**************************************************************************/
+class LiveSuperResolution
+{
+public:
+  /**
+  *************************************************************************
+  @param [in] nWindowSize number of frames used for the reconstruction
+  @param [in] nScale upscaling factor
+  @param [in] nIterations back projection iterations per new frame
+  @param [in] nOutputInterval a frame is emitted every nOutputInterval input frames
+  ************************************************************************/
+  LiveSuperResolution(int nWindowSize = 8, int nScale = 2, int nIterations = 2, int nOutputInterval = 1)
+    : m_nWindowSize(nWindowSize)
+    , m_nScale(nScale)
+    , m_nIterations(nIterations)
+    , m_nOutputInterval(nOutputInterval)
+    , m_nFrameCount(0)
+    , m_fStepSize(1.0f)
+    , m_dMinResponse(0.05)
+  {
+  }
+
+  /**
+  *************************************************************************
+  reset the window (e.g. after a scene change)
+  ************************************************************************/
+  void reset()
+  {
+    m_deqFrames.clear();
+    m_matEstimate.release();
+  }
+
+  /**
+  *************************************************************************
+  add a live frame
+
+  @param [in] frame live frame from irapi::Cam::captureLiveIr()
+  @param [out] frameSr upscaled frame (only set if true is returned)
+  @return true if a new upscaled frame is available
+  ************************************************************************/
+  bool addFrame(const irapi::IrFrame& frame, irapi::IrFrame& frameSr)
+  {
+    if (!m_deqFrames.empty() && m_deqFrames.back().matData.size() != frame.matIrData.size())
+    {
+      reset();
+    }
+
+    cv::Point2d ptShift(0.0, 0.0);
+    if (!m_deqFrames.empty())
+    {
+      if (m_matWindow.size() != frame.matIrData.size())
+      {
+        cv::createHanningWindow(m_matWindow, frame.matIrData.size(), CV_32F);
+      }
+
+      double dResponse = 0.0;
+      ptShift = cv::phaseCorrelate(m_deqFrames.back().matData, frame.matIrData, m_matWindow, &dResponse);
+      if (dResponse < m_dMinResponse)
+      {
+        // registration failed (scene change or too less structure)
+        reset();
+        ptShift = cv::Point2d(0.0, 0.0);
+      }
+    }
+
+    // all shifts are relative to the newest frame
+    for (auto& item : m_deqFrames)
+    {
+      item.ptShift += ptShift;
+    }
+
+    WindowFrame windowFrame;
+    if (m_deqFrames.size() >= size_t(m_nWindowSize))
+    {
+      // reuse the buffer of the oldest frame
+      windowFrame = m_deqFrames.front();
+      m_deqFrames.pop_front();
+    }
+    frame.matIrData.copyTo(windowFrame.matData);
+    windowFrame.ptShift = cv::Point2d(0.0, 0.0);
+    m_deqFrames.push_back(windowFrame);
+
+    updateEstimate(frame.matIrData, ptShift);
+
+    if (++m_nFrameCount % m_nOutputInterval != 0)
+    {
+      return false;
+    }
+
+    frameSr.matIrData = m_matEstimate.clone();
+    frameSr.fScaleMin = frame.fScaleMin;
+    frameSr.fScaleMax = frame.fScaleMax;
+    frameSr.matScaleGradient = frame.matScaleGradient;
+    palletizeFrame(frameSr);
+    return true;
+  }
+
+private:
+  struct WindowFrame
+  {
+    cv::Mat_<float> matData;
+    // position of the frame content in the newest frame (pixel)
+    cv::Point2d ptShift;
+  };
+
+  void updateEstimate(const cv::Mat_<float>& matNewest, const cv::Point2d& ptShift)
+  {
+    const cv::Size sizeHr(matNewest.cols * m_nScale, matNewest.rows * m_nScale);
+
+    if (m_matEstimate.size() != sizeHr)
+    {
+      cv::resize(matNewest, m_matEstimate, sizeHr, 0, 0, cv::INTER_CUBIC);
+    }
+    else
+    {
+      // warm start: move the previous estimate to the position of the newest frame
+      warp(m_matEstimate, m_matWarped, -ptShift);
+      std::swap(m_matEstimate, m_matWarped);
+    }
+
+    for (int nIteration = 0; nIteration < m_nIterations; nIteration++)
+    {
+      m_matCorrection.create(sizeHr);
+      m_matCorrection.setTo(0.0f);
+
+      for (const auto& item : m_deqFrames)
+      {
+        // simulate the low resolution frame from the estimate
+        warp(m_matEstimate, m_matWarped, item.ptShift);
+        cv::resize(m_matWarped, m_matSimulated, item.matData.size(), 0, 0, cv::INTER_AREA);
+        cv::subtract(item.matData, m_matSimulated, m_matSimulated);
+
+        // project the error back to the high resolution grid
+        cv::resize(m_matSimulated, m_matWarped, sizeHr, 0, 0, cv::INTER_LINEAR);
+        warp(m_matWarped, m_matError, -item.ptShift);
+        m_matCorrection += m_matError;
+      }
+
+      cv::scaleAdd(m_matCorrection, m_fStepSize / float(m_deqFrames.size()), m_matEstimate, m_matEstimate);
+    }
+  }
+
+  // dst(x) = src(x + shift) with the shift given in low resolution pixel
+  void warp(const cv::Mat_<float>& matSrc, cv::Mat_<float>& matDst, const cv::Point2d& ptShift) const
+  {
+    cv::Matx23d matTransform(1.0, 0.0, ptShift.x * m_nScale,
+                             0.0, 1.0, ptShift.y * m_nScale);
+    cv::warpAffine(matSrc, matDst, matTransform, matSrc.size(),
+                   cv::INTER_LINEAR | cv::WARP_INVERSE_MAP, cv::BORDER_REPLICATE);
+  }
+
+  int m_nWindowSize;
+  int m_nScale;
+  int m_nIterations;
+  int m_nOutputInterval;
+  int m_nFrameCount;
+  float m_fStepSize;
+  double m_dMinResponse;
+
+  std::deque<WindowFrame> m_deqFrames;
+  cv::Mat_<float> m_matWindow;
+
+  // working buffers are kept to avoid allocations per frame
+  cv::Mat_<float> m_matEstimate;
+  cv::Mat_<float> m_matWarped;
+  cv::Mat_<float> m_matSimulated;
+  cv::Mat_<float> m_matError;
+  cv::Mat_<float> m_matCorrection;
+};
+
+int main(int argc, char* argv[])
+{
+  // This program upscales the live stream of a testo ir camera
+  // call parameter: [window size] [output interval]
+
+  int nWindowSize = (argc > 1) ? std::atoi(argv[1]) : 8;
+  int nOutputInterval = (argc > 2) ? std::atoi(argv[2]) : 1;
+
+  irapi::Cam cam;
+  if (!cam.waitUntilConnected(6000))
+  {
+    std::cout << "Could not connect to a camera! --> end programm here\n\n";
+    return -1;
+  }
+
+  std::cout << "Press any key to end live view! (fokus stream window)" << std::endl;
+
+  const char* szWindowName = "Live";
+  const char* szWindowNameSr = "Live super resolution";
+  LiveSuperResolution superResolution(std::max(nWindowSize, 1), 2, 2, std::max(nOutputInterval, 1));
+
+  for (int i = 0; i < 1000; i++)
+  {
+    irapi::IrFrame frame;
+    irapi::IrFrame frameSr;
+
+    try
+    {
+      frame = cam.captureLiveIr();
+    }
+    catch (std::exception& e)
+    {
+      // camera was disconnected?
+      std::cout << "got error: " << e.what();
+      return -1;
+    }
+
+    cv::imshow(szWindowName, frame.matIrBgr);
+
+    int64 nStart = cv::getTickCount();
+    if (superResolution.addFrame(frame, frameSr))
+    {
+      std::cout << "super resolution update: "
+        << (cv::getTickCount() - nStart) * 1000.0 / cv::getTickFrequency() << " ms" << std::endl;
+      cv::imshow(szWindowNameSr, frameSr.matIrBgr);
+    }
+
+    if (cv::waitKey(10) != -1) break; // end loop early
+  }
+
+  cam.stopLiveIr();
+  cv::destroyAllWindows();
+}
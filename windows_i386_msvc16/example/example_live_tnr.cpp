@@ -0,0 +1,90 @@
+#include <irapi/Cam.h>
+
+#include "TemporalNoiseReduction.h"
+
+#include <string>
+#include <cstdlib>
+#include <iostream>
+
+#include <opencv2/highgui/highgui.hpp>
+
+int main(int argc, char* argv[])
+{
+  // This program filters the live temperature data and compares a simple
+  // threshold alarm on the raw and on the filtered maximal temperature
+  // call parameter: [alarm threshold in degree Celsius] [strength 0...1]
+
+  float fAlarmThreshold = (argc > 1) ? float(std::atof(argv[1])) : 30.0f;
+  float fStrength = (argc > 2) ? float(std::atof(argv[2])) : 0.8f;
+
+  irapi::Cam cam;
+  if (!cam.waitUntilConnected(6000))
+  {
+    std::cout << "Could not connect to a camera! --> end programm here\n\n";
+    return -1;
+  }
+
+  std::cout << "Press any key to end live view! (fokus stream window)" << std::endl;
+
+  const char* szWindowName = "LiveImageData (opencv palette)";
+  TemporalNoiseReduction tnr(fStrength);
+  cv::Mat_<float> matFiltered;
+
+  bool bAlarmRaw = false;
+  bool bAlarmFiltered = false;
+  int nTogglesRaw = 0;
+  int nTogglesFiltered = 0;
+  double dFilterMs = 0.0;
+  int nFrames = 0;
+
+  for (int i = 0; i < 1000; i++)
+  {
+    irapi::IrFrame frame;
+
+    try
+    {
+      frame = cam.captureLiveIr();
+    }
+    catch (std::exception& e)
+    {
+      // camera was disconnected?
+      std::cout << "got error: " << e.what();
+      return -1;
+    }
+
+    int64 nStart = cv::getTickCount();
+    tnr.apply(frame.matIrData, matFiltered);
+    dFilterMs += (cv::getTickCount() - nStart) * 1000.0 / cv::getTickFrequency();
+    nFrames++;
+
+    double dMaxRaw = 0.0;
+    double dMaxFiltered = 0.0;
+    cv::minMaxLoc(frame.matIrData, nullptr, &dMaxRaw);
+    cv::minMaxLoc(matFiltered, nullptr, &dMaxFiltered);
+
+    if ((dMaxRaw > fAlarmThreshold) != bAlarmRaw)
+    {
+      bAlarmRaw = !bAlarmRaw;
+      nTogglesRaw++;
+    }
+    if ((dMaxFiltered > fAlarmThreshold) != bAlarmFiltered)
+    {
+      bAlarmFiltered = !bAlarmFiltered;
+      nTogglesFiltered++;
+    }
+
+    cv::imshow(szWindowName, frame.matIrBgr);
+    if (cv::waitKey(10) != -1) break; // end loop early
+  }
+
+  cam.stopLiveIr();
+  cv::destroyAllWindows();
+
+  if (nFrames > 0)
+  {
+    std::cout << "frames             : " << nFrames << std::endl;
+    std::cout << "filter time        : " << dFilterMs / nFrames << " ms per frame" << std::endl;
+    std::cout << "alarm changes raw  : " << nTogglesRaw << std::endl;
+    std::cout << "alarm changes tnr  : " << nTogglesFiltered << std::endl;
+  }
+}
@@ -0,0 +1,78 @@
+#include <irapi/Image.h>
+
+#include "MeasurementExport.h"
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <iostream>
+#include <fstream>
+
+int main(int argc, char* argv[])
+{
+  // This program exports the measurement points and areas of many BMT
+  // files into one columnar file (see MeasurementColumnWriter)
+  // call parameter: <output file> <bmt file> [bmt file ...]
+
+  if (argc < 3)
+  {
+    std::cout << "usage: example_meas_export <output file> <bmt file> [bmt file ...]\n";
+    return -1;
+  }
+
+  std::vector<std::string> vecFiles(argv + 2, argv + argc);
+  std::ofstream ofs(argv[1], std::ios::binary);
+  if (!ofs.is_open())
+  {
+    std::cout << "Could not open output file: " << argv[1] << std::endl;
+    return -1;
+  }
+
+  const int nThreads = int(std::max(1u, std::thread::hardware_concurrency()));
+
+  int64 nTicks = cv::getTickCount();
+  MeasurementExportResult result;
+  try
+  {
+    MeasurementColumnWriter writer(ofs);
+    result = exportMeasurements(vecFiles, writer, nThreads);
+    writer.finish();
+  }
+  catch (std::exception& e)
+  {
+    std::cout << "Export failed: " << e.what() << std::endl;
+    return -1;
+  }
+  double dMs = (cv::getTickCount() - nTicks) * 1000.0 / cv::getTickFrequency();
+  ofs.close();
+
+  // read the footer back to check the file
+  try
+  {
+    std::ifstream ifs(argv[1], std::ios::binary);
+    MeasurementColumnReader reader(ifs);
+    if (reader.getRows() != result.nRows)
+    {
+      std::cout << "Export check failed: " << reader.getRows() << " rows in the file" << std::endl;
+      return -1;
+    }
+    std::cout << "chunks  : " << reader.getChunks() << ", columns: " << reader.getColumns().size() << std::endl;
+  }
+  catch (std::exception& e)
+  {
+    std::cout << "Export check failed: " << e.what() << std::endl;
+    return -1;
+  }
+
+  for (const auto& item : result.vecFailed)
+  {
+    std::cout << "failed: " << item.first << " (" << item.second << ")" << std::endl;
+  }
+
+  std::cout << "images  : " << result.nImages << std::endl;
+  std::cout << "rows    : " << result.nRows << std::endl;
+  std::cout << "threads : " << nThreads << std::endl;
+  std::cout << "time    : " << dMs << " ms" << std::endl;
+
+  return result.vecFailed.empty() ? 0 : 1;
+}
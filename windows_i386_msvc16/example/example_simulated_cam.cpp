@@ -0,0 +1,93 @@
+#include <irapi/Cam.h>
+
+#include "SimulatedCam.h"
+
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+
+/**
+*************************************************************************
+Measures file transfer and live stream of a camera. The function is a
+template, so it runs with irapi::Cam and SimulatedCam.
+************************************************************************/
+template <typename CamType>
+void benchmarkCam(CamType& cam, int nFrames)
+{
+  std::cout << "Serial: " << cam.getDeviceSerialNumber() << std::endl;
+  std::cout << "DeviceType: " << cam.getDeviceType() << std::endl;
+
+  // file transfer
+  std::map<std::string, uint64_t> mapFiles(cam.listDirectoryContent());
+  size_t nBytes = 0;
+  int64 nTicks = cv::getTickCount();
+  for (const auto& item : mapFiles)
+  {
+    nBytes += cam.getFileContent(item.first).size();
+    cam.getIrFilePreview(item.first);
+  }
+  double dMs = (cv::getTickCount() - nTicks) * 1000.0 / cv::getTickFrequency();
+  std::cout << "files      : " << mapFiles.size() << " (" << nBytes / 1024 << " kB) in " << dMs << " ms" << std::endl;
+
+  // live stream
+  nTicks = cv::getTickCount();
+  for (int i = 0; i < nFrames; i++)
+  {
+    irapi::IrFrame frame = cam.captureLiveIr();
+    if (frame.matIrData.empty())
+    {
+      std::cout << "got empty frame" << std::endl;
+    }
+  }
+  dMs = (cv::getTickCount() - nTicks) * 1000.0 / cv::getTickFrequency();
+  cam.stopLiveIr();
+  std::cout << "live       : " << nFrames << " frames in " << dMs << " ms ("
+    << nFrames * 1000.0 / dMs << " Hz)" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  // This program runs the same benchmark on a simulated camera
+  // (replaying bmt files) or on a connected camera
+  // call parameter: [frame rate] [bmt file ...]
+  //             or: camera
+
+  if (argc > 1 && std::string(argv[1]) == "camera")
+  {
+    irapi::Cam cam;
+    if (!cam.waitUntilConnected(6000))
+    {
+      std::cout << "Could not connect to a camera! --> end programm here\n\n";
+      return -1;
+    }
+    benchmarkCam(cam, 50);
+    return 0;
+  }
+
+  double dFrameRate = (argc > 1) ? std::atof(argv[1]) : 4.5;
+  std::vector<std::string> vecFiles(argv + std::min(argc, 2), argv + argc);
+  if (vecFiles.empty())
+  {
+    vecFiles.push_back("IR_EXAMPLE.BMT");
+  }
+
+  try
+  {
+    SimulatedCam cam(vecFiles, dFrameRate);
+
+    // configured rate
+    benchmarkCam(cam, 50);
+
+    // maximal throughput of the client code
+    cam.setFrameRate(0.0);
+    benchmarkCam(cam, 1000);
+  }
+  catch (std::exception& e)
+  {
+    std::cout << "got error: " << e.what() << std::endl;
+    return -1;
+  }
+
+  return 0;
+}